@@ -0,0 +1,103 @@
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "allocations.hpp"
+#include "json.hpp"
+#include "sampler.hpp"
+#include "state.hpp"
+
+/// Heap allocations of the perfect and lockstep samplers, counted by the allocation hook linked into the
+/// benchmarks (see allocations.hpp). For each model, samples are drawn on a random bounded-degree graph with
+/// each engine, and the allocations and bytes are reported per sample, per epoch and per update. The updates
+/// of phase two, the steady state of the perfect sampler, are also reported on their own, summed from the
+/// trace spans of a second, identical run.
+///
+/// usage: potts-bench-allocations [vertices] [samples]
+
+struct Engine {
+    std::string name;
+    SamplingOptions options;
+};
+
+/// the allocations and updates recorded by the trace spans called name
+static std::pair<double, double> spanTotals(const Json &trace, const std::string &name) {
+    double allocations = 0, updates = 0;
+    for (const Json &event : trace.find("traceEvents")->elements) {
+        const Json *args = event.find("args");
+        if (event.find("name")->string == name && args && args->find("updates")) {
+            allocations += args->find("allocations")->number;
+            updates += args->find("updates")->number;
+        }
+    }
+    return {allocations, updates};
+}
+
+int main(int argc, char **argv) {
+    const int numNodes   = argc > 1 ? std::stoi(argv[1]) : 100;
+    const int numSamples = argc > 2 ? std::stoi(argv[2]) : 8;
+
+    if (!allocations::counting()) {
+        std::cerr << "potts-bench-allocations must be linked with potts-allocation-hook." << std::endl;
+        return 1;
+    }
+
+    // (q, Delta) pairs with a fixed kernel by default, and one using the generic kernel
+    const std::vector<std::pair<int, int>> models{{7, 3}, {9, 4}, {11, 4}};
+
+    std::vector<Engine> engines(3);
+    engines[0].name = "perfect";
+    engines[1].name = "regenerated";
+    engines[1].options.history = SamplingOptions::History::REGENERATED;
+    engines[2].name = "lockstep";
+    engines[2].options.engine = SamplingOptions::Engine::LOCKSTEP;
+
+    std::cout << "engine,colours,delta,vertices,samples,allocations/sample,bytes/sample,allocations/epoch,"
+                 "bytes/epoch,allocations/update,bytes/update,phase two allocations/update"
+              << std::endl;
+    for (const auto &[maxColours, maxDegree] : models) {
+        const Graph graph = Graph::random(numNodes, maxDegree, 0);
+        const Parameters params{numNodes, maxColours, 0.95L};
+        if (!params.verify(graph)) {
+            continue;
+        }
+
+        // each epoch makes a contract update per vertex, a compress update per edge and the updates of phase two
+        const double updatesPerEpoch =
+            numNodes + graph.numEdges() + std::max<std::int64_t>(getPhaseTwoIters(graph, params), 0);
+
+        for (const Engine &engine : engines) {
+            seed(0, 0);
+            const allocations::Counts before = allocations::current();
+            const Samples samples            = *sample(params, graph, numSamples, engine.options);
+            const allocations::Counts made   = allocations::current() - before;
+
+            const double epochs  = std::accumulate(samples.epochs.begin(), samples.epochs.end(), 0.0);
+            const double updates = epochs * updatesPerEpoch;
+
+            std::cout << engine.name << ',' << maxColours << ',' << graph.getMaxDegree() << ',' << numNodes << ','
+                      << numSamples << ',' << made.allocations / double(numSamples) << ','
+                      << made.bytes / double(numSamples) << ',' << made.allocations / epochs << ','
+                      << made.bytes / epochs << ',' << made.allocations / updates << ',' << made.bytes / updates
+                      << ',';
+
+            // the lockstep engine has no phase spans
+            if (engine.options.engine == SamplingOptions::Engine::PERFECT) {
+                seed(0, 0);
+                startTrace();
+                sample(params, graph, numSamples, engine.options);
+                std::ostringstream trace;
+                stopTrace(trace);
+
+                const auto [phaseTwoAllocations, phaseTwoUpdates] = spanTotals(Json::parse(trace.str()), "phase two");
+                std::cout << phaseTwoAllocations / phaseTwoUpdates;
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    return 0;
+}
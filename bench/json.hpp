@@ -0,0 +1,127 @@
+#ifndef POTTSSAMPLER_BENCH_JSON_H
+#define POTTSSAMPLER_BENCH_JSON_H
+
+#include <cctype>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+/// A minimal JSON reader, enough to load the reports written by the benchmarks.
+struct Json {
+    enum Kind { NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+
+    Kind kind = NUL;
+    double number = 0;
+    std::string string;
+    std::vector<Json> elements;
+    std::vector<std::pair<std::string, Json>> members;
+
+    /// \return the member called key, or null if there is none
+    const Json *find(const std::string &key) const {
+        for (const auto &[name, value] : members) {
+            if (name == key) {
+                return &value;
+            }
+        }
+        return nullptr;
+    }
+
+    static Json parse(const std::string &text) {
+        std::size_t position = 0;
+        Json value           = parse(text, position);
+        skipSpace(text, position);
+        if (position != text.size()) {
+            throw std::invalid_argument("Trailing characters in JSON.");
+        }
+        return value;
+    }
+
+   private:
+    static void skipSpace(const std::string &text, std::size_t &position) {
+        while (position < text.size() && std::isspace(static_cast<unsigned char>(text[position]))) {
+            position++;
+        }
+    }
+
+    static void expect(const std::string &text, std::size_t &position, char c) {
+        skipSpace(text, position);
+        if (position >= text.size() || text[position] != c) {
+            throw std::invalid_argument(std::string("Expected '") + c + "' in JSON.");
+        }
+        position++;
+    }
+
+    static std::string parseString(const std::string &text, std::size_t &position) {
+        expect(text, position, '"');
+        std::string result;
+        while (position < text.size() && text[position] != '"') {
+            if (text[position] == '\\') {
+                position++;
+            }
+            result += text[position++];
+        }
+        expect(text, position, '"');
+        return result;
+    }
+
+    static Json parse(const std::string &text, std::size_t &position) {
+        skipSpace(text, position);
+        if (position >= text.size()) {
+            throw std::invalid_argument("Unexpected end of JSON.");
+        }
+
+        Json value;
+        const char c = text[position];
+        if (c == '{') {
+            value.kind = OBJECT;
+            position++;
+            skipSpace(text, position);
+            while (position < text.size() && text[position] != '}') {
+                std::string key = parseString(text, position);
+                expect(text, position, ':');
+                value.members.emplace_back(std::move(key), parse(text, position));
+                skipSpace(text, position);
+                if (text[position] == ',') {
+                    position++;
+                    skipSpace(text, position);
+                }
+            }
+            expect(text, position, '}');
+        } else if (c == '[') {
+            value.kind = ARRAY;
+            position++;
+            skipSpace(text, position);
+            while (position < text.size() && text[position] != ']') {
+                value.elements.push_back(parse(text, position));
+                skipSpace(text, position);
+                if (text[position] == ',') {
+                    position++;
+                    skipSpace(text, position);
+                }
+            }
+            expect(text, position, ']');
+        } else if (c == '"') {
+            value.kind   = STRING;
+            value.string = parseString(text, position);
+        } else if (text.compare(position, 4, "true") == 0 || text.compare(position, 5, "false") == 0) {
+            value.kind   = BOOLEAN;
+            value.number = text[position] == 't';
+            position += value.number ? 4 : 5;
+        } else if (text.compare(position, 4, "null") == 0) {
+            position += 4;
+        } else {
+            char *end;
+            value.kind   = NUMBER;
+            value.number = std::strtod(text.c_str() + position, &end);
+            if (end == text.c_str() + position) {
+                throw std::invalid_argument("Invalid value in JSON.");
+            }
+            position = end - text.c_str();
+        }
+        return value;
+    }
+};
+
+#endif  // POTTSSAMPLER_BENCH_JSON_H
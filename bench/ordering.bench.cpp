@@ -0,0 +1,37 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "sampler.hpp"
+
+/// time sample() on large random graphs with each vertex ordering
+/// usage: potts-bench-ordering [vertices] [repeats]
+int main(int argc, char **argv) {
+    const int numNodes = argc > 1 ? std::stoi(argv[1]) : 1000;
+    const int repeats  = argc > 2 ? std::stoi(argv[2]) : 3;
+
+    static constexpr int maxDegree = 3;
+    const Parameters params{numNodes, 7, 0.95L};
+
+    const std::vector<std::pair<std::string, Graph::Ordering>> orderings{
+        {"none",   Graph::Ordering::NONE                 },
+        {"bfs",    Graph::Ordering::BFS                  },
+        {"rcm",    Graph::Ordering::REVERSE_CUTHILL_MCKEE},
+        {"degree", Graph::Ordering::DEGREE               },
+    };
+
+    std::cout << "ordering,vertices,repeat,seconds" << std::endl;
+    for (const auto &[name, ordering] : orderings) {
+        const Graph graph = Graph::random(numNodes, maxDegree, 0, ordering);
+        for (int r = 0; r < repeats; r++) {
+            auto start = std::chrono::steady_clock::now();
+            sample(params, graph);
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            std::cout << name << ',' << numNodes << ',' << r << ',' << elapsed.count() << std::endl;
+        }
+    }
+
+    return 0;
+}
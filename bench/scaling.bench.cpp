@@ -0,0 +1,222 @@
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "json.hpp"
+#include "sampler.hpp"
+
+/// Empirical check of the expected O(n^2) run-time: times repeated perfect samples on
+/// random bounded-degree graphs of increasing size, fits t = c * n^k to the mean wall
+/// time, writes a JSON report and optionally compares its exponents against a baseline
+/// report. The number of epochs is not fitted: with the phase two schedule of
+/// getPhaseTwoIters, nearly every sample coalesces in its first epoch at any size.
+///
+/// usage: potts-scaling [--sizes 16,32,64,128] [--repeats 5] [--output scaling.json]
+///                      [--baseline scaling.baseline.json] [--exponent-tolerance 0.3]
+
+struct Point {
+    int maxColours;
+    int maxDegree;
+    long double temperature;
+
+    std::string name() const {
+        std::ostringstream out;
+        out << "q" << maxColours << "-d" << maxDegree << "-T" << static_cast<double>(temperature);
+        return out.str();
+    }
+};
+
+struct Measurement {
+    int vertices;
+    double seconds;
+};
+
+struct Fit {
+    double exponent;
+    double constant;
+};
+
+/// least squares fit of log t = log c + k log n
+static Fit fit(const std::vector<Measurement> &measurements) {
+    double n = 0, sx = 0, sy = 0, sxx = 0, sxy = 0;
+    for (const Measurement &measurement : measurements) {
+        if (measurement.seconds <= 0) {
+            continue;
+        }
+        double x = std::log(measurement.vertices), y = std::log(measurement.seconds);
+        n += 1, sx += x, sy += y, sxx += x * x, sxy += x * y;
+    }
+
+    if (n < 2 || n * sxx == sx * sx) {
+        return {std::nan(""), std::nan("")};
+    }
+
+    double exponent = (n * sxy - sx * sy) / (n * sxx - sx * sx);
+    return {exponent, std::exp((sy - exponent * sx) / n)};
+}
+
+static std::vector<int> parseSizes(const std::string &list) {
+    std::vector<int> sizes;
+    std::istringstream in(list);
+    for (std::string size; std::getline(in, size, ',');) {
+        sizes.push_back(std::stoi(size));
+    }
+    return sizes;
+}
+
+/// \return the member key of value
+/// \throw std::runtime_error naming the member and the report it is missing from
+static const Json &member(const Json &value, const std::string &key, const std::string &where) {
+    const Json *result = value.find(key);
+    if (!result) {
+        throw std::runtime_error("Missing \"" + key + "\" in " + where + ".");
+    }
+    return *result;
+}
+
+/// a number of the report; a failed fit is NaN, which JSON cannot hold, so it is written as null
+static std::string number(double value) {
+    if (!std::isfinite(value)) {
+        return "null";
+    }
+    std::ostringstream out;
+    out << value;
+    return out.str();
+}
+
+/// \return the number of regressions found; only the exponents are compared, since the wall times of the
+/// baseline come from whichever machine wrote it
+/// \throw std::runtime_error if either report is missing a member
+static int compare(const Json &report, const Json &baseline, double exponentTolerance) {
+    int regressions = 0;
+    for (const Json &point : member(report, "points", "the report").elements) {
+        const std::string &name = member(point, "name", "a point of the report").string;
+
+        const Json *base = nullptr;
+        for (const Json &candidate : member(baseline, "points", "the baseline").elements) {
+            if (member(candidate, "name", "a point of the baseline").string == name) {
+                base = &candidate;
+            }
+        }
+        if (!base) {
+            std::cerr << "no baseline for " << name << std::endl;
+            continue;
+        }
+
+        const Json &exponent     = member(member(point, "seconds", name), "exponent", name + " seconds");
+        const Json &baseExponent = member(member(*base, "seconds", "the baseline of " + name), "exponent",
+                                          "the baseline of " + name + " seconds");
+        if (exponent.kind != Json::NUMBER || baseExponent.kind != Json::NUMBER) {
+            std::cerr << "no fit of " << name << " to compare" << std::endl;
+            continue;
+        }
+        if (exponent.number > baseExponent.number + exponentTolerance) {
+            std::cerr << "REGRESSION: " << name << " exponent " << exponent.number << " exceeds baseline "
+                      << baseExponent.number << std::endl;
+            regressions++;
+        }
+    }
+
+    return regressions;
+}
+
+int main(int argc, char **argv) {
+    std::vector<int> sizes{16, 32, 64, 128};
+    int repeats = 5;
+    std::string output = "scaling.json", baselinePath;
+    double exponentTolerance = 0.3;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string flag = argv[i], value = argv[i + 1];
+        if (flag == "--sizes") {
+            sizes = parseSizes(value);
+        } else if (flag == "--repeats") {
+            repeats = std::stoi(value);
+        } else if (flag == "--output") {
+            output = value;
+        } else if (flag == "--baseline") {
+            baselinePath = value;
+        } else if (flag == "--exponent-tolerance") {
+            exponentTolerance = std::stod(value);
+        } else {
+            std::cerr << "Unknown option " << flag << std::endl;
+            return 2;
+        }
+    }
+
+    // points satisfying q > 2 * Delta and B > 1 - (q - 2 * Delta) / Delta
+    const std::vector<Point> points{
+        {7,  3, 0.95L},
+        {9,  4, 0.95L},
+        {13, 6, 0.9L },
+    };
+
+    std::ostringstream report;
+    report << "{\n  \"repeats\": " << repeats << ",\n  \"points\": [";
+    for (int p = 0; p < points.size(); p++) {
+        const Point &point = points[p];
+
+        std::vector<Measurement> measurements;
+        for (int n : sizes) {
+            const Graph graph = Graph::random(n, point.maxDegree, n);
+            const Parameters params{n, point.maxColours, point.temperature};
+
+            Measurement measurement{n, 0};
+            for (int r = 0; r < repeats; r++) {
+                auto start   = std::chrono::steady_clock::now();
+                auto samples = sample(params, graph, 1, SamplingOptions{});
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                if (!samples) {
+                    return 2;
+                }
+
+                measurement.seconds += elapsed.count() / repeats;
+            }
+
+            std::cout << point.name() << " n = " << n << ": " << measurement.seconds << "s" << std::endl;
+            measurements.push_back(measurement);
+        }
+
+        Fit seconds = fit(measurements);
+        std::cout << point.name() << ": seconds ~ " << seconds.constant << " n^" << seconds.exponent << std::endl;
+
+        report << (p ? "," : "") << "\n    {\n      \"name\": \"" << point.name() << "\",\n"
+               << "      \"maxColours\": " << point.maxColours << ",\n"
+               << "      \"maxDegree\": " << point.maxDegree << ",\n"
+               << "      \"temperature\": " << static_cast<double>(point.temperature) << ",\n"
+               << "      \"measurements\": [";
+        for (int i = 0; i < measurements.size(); i++) {
+            report << (i ? ", " : "") << "{\"vertices\": " << measurements[i].vertices
+                   << ", \"seconds\": " << measurements[i].seconds << "}";
+        }
+        report << "],\n"
+               << "      \"seconds\": {\"exponent\": " << number(seconds.exponent)
+               << ", \"constant\": " << number(seconds.constant) << "}\n    }";
+    }
+    report << "\n  ]\n}\n";
+
+    std::ofstream(output) << report.str();
+
+    if (!baselinePath.empty()) {
+        std::ifstream in(baselinePath);
+        std::stringstream baseline;
+        baseline << in.rdbuf();
+
+        int regressions;
+        try {
+            regressions = compare(Json::parse(report.str()), Json::parse(baseline.str()), exponentTolerance);
+        } catch (const std::exception &err) {
+            std::cerr << "Cannot compare against " << baselinePath << ": " << err.what() << std::endl;
+            return 2;
+        }
+        std::cout << regressions << " regression(s) against " << baselinePath << std::endl;
+        return regressions ? 1 : 0;
+    }
+
+    return 0;
+}
@@ -0,0 +1,75 @@
+#ifndef POTTSSAMPLER_POTTS_H
+#define POTTSSAMPLER_POTTS_H
+
+/* C interface to the perfect sampler, exported by the potts shared library.
+ *
+ * The graph is passed in compressed sparse rows which are borrowed, not
+ * copied: they must outlive the sampler. Samples are written directly into
+ * caller-owned buffers, one row of num_nodes colours per sample, indexed by
+ * vertex. Functions returning a potts_status leave a description of any
+ * failure in potts_last_error. */
+
+#include <stdint.h>
+
+#if defined(_WIN32)
+#if defined(POTTS_BUILDING)
+#define POTTS_API __declspec(dllexport)
+#else
+#define POTTS_API __declspec(dllimport)
+#endif
+#else
+#define POTTS_API __attribute__((visibility("default")))
+#endif
+
+/* incremented on any incompatible change to this interface */
+#define POTTS_ABI_VERSION 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum potts_status {
+    POTTS_OK = 0,
+    /* a null pointer, malformed graph or out-of-range argument */
+    POTTS_INVALID_ARGUMENT = 1,
+    /* the parameters fail the conditions of the perfect sampler (q > 2 Delta, ...) */
+    POTTS_UNSUPPORTED_PARAMETERS = 2,
+    /* the colour type of the output buffer cannot hold max_colours colours */
+    POTTS_COLOUR_OVERFLOW = 3,
+    POTTS_ERROR = 4
+} potts_status;
+
+typedef struct potts_sampler potts_sampler;
+
+/* the POTTS_ABI_VERSION the library was built with */
+POTTS_API int32_t potts_abi_version(void);
+
+/* the message of the last failure on the calling thread, or an empty string */
+POTTS_API const char *potts_last_error(void);
+
+/* create a sampler over a graph in compressed sparse rows
+ * offsets: num_nodes + 1 non-decreasing entries, starting at 0
+ * targets: the neighbours of v are targets[offsets[v]], ..., targets[offsets[v + 1] - 1], with every edge listed
+ *          in the rows of both endpoints */
+POTTS_API potts_status potts_sampler_create(int32_t num_nodes, const int64_t *offsets, const int32_t *targets,
+                                            int32_t max_colours, double temperature, potts_sampler **sampler);
+
+POTTS_API void potts_sampler_destroy(potts_sampler *sampler);
+
+/* the number of threads used by the potts_sample_* calls, 1 by default */
+POTTS_API potts_status potts_sampler_set_threads(potts_sampler *sampler, int32_t num_threads);
+
+/* make subsequent samples reproducible: the ith sample drawn after this call depends only on (seed, i), whatever
+ * the number of threads. Unseeded samplers draw from nondeterministically seeded generators. */
+POTTS_API potts_status potts_sampler_set_seed(potts_sampler *sampler, uint64_t seed);
+
+/* write num_samples samples to out, which must hold num_samples * num_nodes colours */
+POTTS_API potts_status potts_sample_int32(potts_sampler *sampler, int32_t num_samples, int32_t *out);
+POTTS_API potts_status potts_sample_uint16(potts_sampler *sampler, int32_t num_samples, uint16_t *out);
+POTTS_API potts_status potts_sample_uint8(potts_sampler *sampler, int32_t num_samples, uint8_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* POTTSSAMPLER_POTTS_H */
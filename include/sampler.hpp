@@ -1,7 +1,12 @@
 #ifndef POTTSSAMPLER_SAMPLER_H
 #define POTTSSAMPLER_SAMPLER_H
 
+#include <algorithm>
+#include <cstdint>
+#include <functional>
 #include <iostream>
+#include <iterator>
+#include <memory>
 #include <string>
 #include <vector>
 #include <optional>
@@ -18,41 +23,310 @@ struct Parameters {
     // Temperature
     long double temperature;
 
+    /// \return a message for each condition of the perfect sampler the parameters fail on the graph,
+    /// none if they can be sampled
+    std::vector<std::string> violations(const Graph&) const;
+
+    /// \sa violations, writing the messages to std::cout
+    /// \return true if there are none
     bool verify(const Graph&) const;
 };
 
+/// a colouring indexed by vertex; colours may be stored in a narrower integer
+/// type (std::uint8_t, std::uint16_t) when maxColours allows it
+template<typename Colour>
+using basic_colouring_t = std::vector<Colour>;
+
+using colouring_t = basic_colouring_t<int>;
+
 class Graph {
    public:
     enum Type { CYCLE, COMPLETE };
 
+    /// the order in which vertices are stored internally; anything other
+    /// than NONE relabels the vertices to improve locality when sampling
+    enum Ordering { NONE, BFS, REVERSE_CUTHILL_MCKEE, DEGREE };
+
     using edge_t = std::pair<int, int>;
 
-    Graph(int numNodes, Type type) : Graph(numNodes, buildEdgeSet(numNodes, type)) {}
+    /// a view of the neighbours of a vertex
+    class Neighbours {
+       public:
+        Neighbours(const int* first, const int* last) : first(first), last(last) {}
+
+        const int* begin() const { return first; }
+
+        const int* end() const { return last; }
+
+        int size() const { return last - first; }
+
+        int operator[](int i) const { return first[i]; }
+
+        friend bool operator==(const Neighbours& neighbours, const std::vector<int>& other) {
+            return std::equal(neighbours.begin(), neighbours.end(), other.begin(), other.end());
+        }
+
+       private:
+        const int* first;
+        const int* last;
+    };
 
-    Graph(int nunNodes, const std::vector<edge_t>& edges);
+    Graph(int numNodes, Type type, Ordering ordering = NONE)
+        : Graph(numNodes, buildEdgeSet(numNodes, type), ordering) {}
 
-    int size() const { return adjacencyMatrix.size(); }
+    Graph(int nunNodes, const std::vector<edge_t>& edges, Ordering ordering = NONE);
 
-    int numEdges() const;
+    /// a random graph with maximum degree at most maxDegree
+    static Graph random(int numNodes, int maxDegree, unsigned seed, Ordering ordering = NONE);
+
+    /// write the graph in a binary, page-aligned layout which can be memory-mapped with Graph::map
+    void save(const std::string& path) const;
+
+    /// map a graph written by Graph::save read-only; pages are shared between processes mapping the same file
+    static Graph map(const std::string& path);
+
+    /// a graph over compressed sparse rows owned by the caller, which are neither copied nor freed
+    /// \param offsets numNodes + 1 non-decreasing offsets into targets, starting at 0
+    /// \param targets the neighbours of v are targets[offsets[v]], ..., targets[offsets[v + 1] - 1]; every
+    /// edge must appear in the rows of both endpoints
+    /// \throw std::invalid_argument if the rows are malformed
+    static Graph view(int numNodes, const std::int64_t* offsets, const int* targets);
+
+    /// a deep copy of the graph on the heap, written by the calling thread; under the usual first-touch
+    /// policy its pages are placed on the NUMA node that thread runs on
+    Graph replicate() const;
+
+    int size() const { return numNodes; }
+
+    int numEdges() const { return offsets[numNodes] / 2; }
 
     int getMaxDegree() const { return maxDegree; }
 
-    const std::vector<int>& getNeighbours(int v) const { return adjacencyMatrix[v]; }
+    /// \param v a vertex in the internal order
+    Neighbours getNeighbours(int v) const { return {targets + offsets[v], targets + offsets[v + 1]}; }
+
+    /// map an internal vertex to the label it was constructed with
+    int toOriginal(int v) const { return labels ? labels[v] : v; }
+
+    /// map a colouring indexed by internal vertex to one indexed by the original labels
+    template<typename Colour = int, typename Colouring>
+    basic_colouring_t<Colour> toOriginal(const Colouring& colouring) const {
+        basic_colouring_t<Colour> result(colouring.size());
+        toOriginal(colouring, result.data());
+        return result;
+    }
+
+    /// \sa toOriginal(const Colouring&), writing into a caller-owned buffer of size() colours
+    template<typename Colouring, typename Colour>
+    void toOriginal(const Colouring& colouring, Colour* result) const {
+        for (int v = 0; v < colouring.size(); v++) {
+            result[toOriginal(v)] = colouring[v];
+        }
+    }
 
     friend std::ostream& operator<<(std::ostream& out, const Graph& graph);
 
    protected:
+    Graph() = default;
+
     static std::vector<edge_t> buildEdgeSet(int n, Type type);
 
-    std::vector<std::vector<int>> adjacencyMatrix;
+    /// \return the vertices in the requested order
+    std::vector<int> order(Ordering ordering) const;
+
+    // owns the arrays below, either on the heap or in a memory-mapped file
+    std::shared_ptr<const void> storage;
+
+    int numNodes = 0;
+
+    // compressed sparse rows: the neighbours of v are targets[offsets[v]], ..., targets[offsets[v + 1] - 1]
+    const std::int64_t* offsets = nullptr;
+    const int* targets          = nullptr;
+
+    // internal vertex -> original label, null when the graph is not reordered
+    const int* labels = nullptr;
+
     int maxDegree = 3;
 };
 
 std::istream& operator>>(std::istream& is, Graph::Type& type);
-
-using colouring_t = std::vector<int>;
+std::istream& operator>>(std::istream& is, Graph::Ordering& ordering);
 
 /// sample from the anti-ferromagnetic Potts model
-std::optional<colouring_t> sample(const Parameters& parameters, const Graph& graph);
+/// \tparam Colour the colour type of the result, one of std::uint8_t, std::uint16_t or int; throws
+/// std::invalid_argument if it cannot hold maxColours colours
+template<typename Colour = int>
+std::optional<basic_colouring_t<Colour>> sample(const Parameters& parameters, const Graph& graph);
+
+/// \sa sample(const Parameters&, const Graph&), writing into a caller-owned buffer of graph.size() colours
+/// \return false, leaving colouring untouched, if the parameters fail Parameters::verify
+template<typename Colour = int>
+bool sample(const Parameters& parameters, const Graph& graph, Colour* colouring);
+
+struct SamplingOptions {
+    /// PERFECT draws exact samples and requires Parameters::verify to hold;
+    /// GLAUBER runs heat-bath Glauber dynamics, which is approximate but
+    /// accepts any parameters; LOCKSTEP draws exact samples from the same
+    /// distribution as PERFECT, though not the same samples for a seed,
+    /// advancing several on one thread in lockstep, for q <= 64
+    enum Engine { PERFECT, GLAUBER, LOCKSTEP };
+
+    Engine engine = PERFECT;
+
+    // Glauber only: sweeps discarded at the start of each chain
+    int sweeps = 100;
+
+    // Glauber only: sweeps between successive samples of a chain
+    int thinning = 10;
+
+    // Glauber only: number of independent chains, run in parallel
+    int chains = 4;
+
+    // Perfect only, and rejected by the lockstep engine: when set, the colouring and
+    // bounding chain are kept in memory-mapped files in this directory rather than on the heap
+    std::string storageDirectory;
+
+    /// how the perfect sampler keeps each epoch for the replay: FULL stores every update, REGENERATED only
+    /// the generator and the bounding chain at the start of the epoch, from which the updates are
+    /// generated again during the replay; this doubles the forward work, but needs O(n q) bits per epoch
+    /// rather than O(n^2 q) updates, and draws the same samples
+    enum History { FULL, REGENERATED };
+
+    // Perfect only; the lockstep engine rejects REGENERATED
+    History history = FULL;
+
+    // Perfect only: when not empty, a colour or -1 for each vertex, indexed by the original labels; the
+    // vertices given a colour keep it, and the others are sampled conditionally on them
+    std::vector<int> pinned;
+};
+
+/// convergence diagnostics for the Glauber engine, computed from the number
+/// of monochromatic edges of each sample
+struct Diagnostics {
+    // integrated autocorrelation time, in samples, averaged over the chains
+    double autocorrelationTime;
+
+    // Gelman-Rubin potential scale reduction factor (NaN with fewer than two chains)
+    double rHat;
+};
+
+template<typename Colour>
+struct BasicSamples {
+    std::vector<basic_colouring_t<Colour>> colourings;
+
+    // only produced by the perfect and lockstep engines: the number of epochs each sample ran before the
+    // bounding chain coalesced
+    std::vector<int> epochs;
+
+    // only produced by the Glauber engine
+    std::optional<Diagnostics> diagnostics;
+};
+
+using Samples = BasicSamples<int>;
+
+/// draw numSamples samples from the anti-ferromagnetic Potts model using the selected engine
+/// \tparam Colour as for sample(const Parameters&, const Graph&)
+template<typename Colour = int>
+std::optional<BasicSamples<Colour>> sample(const Parameters& parameters, const Graph& graph, int numSamples,
+                                           const SamplingOptions& options);
+
+std::istream& operator>>(std::istream& is, SamplingOptions::Engine& engine);
+std::istream& operator>>(std::istream& is, SamplingOptions::History& history);
+
+/// the perfect samples drawn at one point of a parameter sweep
+struct SweepPoint {
+    Parameters parameters;
+    std::vector<colouring_t> colourings;
+};
+
+/// draw numSamples perfect samples at every (temperature, maxColours) point on the same graph
+/// points with Parameters::violations are skipped; the remaining samples are scheduled across
+/// numThreads threads, most expensive first
+/// \param onPoint called once per point as soon as all of its samples are complete; calls are serialised
+/// \param onSkipped called with each skipped point and its violations before any sample is drawn; if not set,
+/// they are written to std::cerr
+void sweep(const Graph& graph, const std::vector<long double>& temperatures, const std::vector<int>& maxColours,
+           int numSamples, int numThreads, const std::function<void(const SweepPoint&)>& onPoint,
+           const std::function<void(const Parameters&, const std::vector<std::string>&)>& onSkipped = {});
+
+/// reseed the generator the calling thread samples from; distinct streams under the same seed give independent
+/// sequences, so that work split across threads or processes can be made reproducible
+void seed(std::uint64_t seed, std::uint64_t stream);
+
+/// start recording a timeline of the perfect sampler on every thread: a span for each sample, epoch,
+/// phase of an epoch and replay, tagged with the number of vertices whose bounding list is not a singleton
+void startTrace();
+
+/// stop recording and write the timeline in Chrome trace-event JSON, which Perfetto and chrome://tracing
+/// open; each thread is shown on its own track
+void stopTrace(std::ostream& out);
+
+/// an unbounded stream of perfect samples, produced ahead of the consumer by background threads
+/// at most capacity completed samples are kept ready; producers wait for the consumer to take one
+/// before starting another, and reuse the buffers handed back with recycle
+/// \tparam Colour as for sample(const Parameters&, const Graph&)
+template<typename Colour>
+class BasicSampleStream {
+   public:
+    using value_type = basic_colouring_t<Colour>;
+
+    /// \throw std::invalid_argument naming the Parameters::violations of the parameters, if any
+    BasicSampleStream(const Parameters& parameters, const Graph& graph, int numThreads = 1, int capacity = 4);
+
+    /// stops the producers, waiting for the samples in progress
+    ~BasicSampleStream();
+
+    BasicSampleStream(const BasicSampleStream&)            = delete;
+    BasicSampleStream& operator=(const BasicSampleStream&) = delete;
+
+    /// block until a sample is ready; rethrows the exception of a failed producer
+    value_type next();
+
+    /// hand back a colouring which is no longer needed, so that its buffer is reused
+    void recycle(value_type&& colouring);
+
+    struct sentinel {};
+
+    /// an input iterator over the stream, which never reaches end(); incrementing recycles the current sample
+    class iterator {
+       public:
+        using value_type        = BasicSampleStream::value_type;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = const value_type*;
+        using reference         = const value_type&;
+        using iterator_category = std::input_iterator_tag;
+
+        explicit iterator(BasicSampleStream& stream) : stream(&stream), current(stream.next()) {}
+
+        reference operator*() const { return current; }
+
+        pointer operator->() const { return &current; }
+
+        iterator& operator++() {
+            stream->recycle(std::move(current));
+            current = stream->next();
+            return *this;
+        }
+
+        friend bool operator!=(const iterator&, sentinel) { return true; }
+
+        friend bool operator==(const iterator&, sentinel) { return false; }
+
+       private:
+        BasicSampleStream* stream;
+        value_type current;
+    };
+
+    /// blocks until the first sample is ready
+    iterator begin() { return iterator(*this); }
+
+    sentinel end() const { return {}; }
+
+   private:
+    struct Shared;
+    std::unique_ptr<Shared> shared;
+};
+
+using SampleStream = BasicSampleStream<int>;
 
 #endif
@@ -0,0 +1,55 @@
+// Replaces the global operator new and delete with versions counting the allocations of each thread, see
+// allocations.hpp. Linked into the tests and benchmarks only.
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+#include "allocations.hpp"
+
+namespace {
+[[maybe_unused]] const bool installed = (allocations::install(), true);
+
+void *allocate(std::size_t bytes) {
+    allocations::record(bytes);
+    // malloc(0) may return null, which operator new may not
+    return std::malloc(bytes ? bytes : 1);
+}
+
+void *allocate(std::size_t bytes, std::align_val_t alignment) {
+    allocations::record(bytes);
+    // aligned_alloc requires a non-zero size which is a multiple of the alignment
+    const auto align = static_cast<std::size_t>(alignment);
+    return std::aligned_alloc(align, std::max(align, (bytes + align - 1) / align * align));
+}
+
+template<typename... Alignment>
+void *allocateOrThrow(std::size_t bytes, Alignment... alignment) {
+    if (void *p = allocate(bytes, alignment...)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+}  // namespace
+
+void *operator new(std::size_t bytes) { return allocateOrThrow(bytes); }
+void *operator new[](std::size_t bytes) { return allocateOrThrow(bytes); }
+void *operator new(std::size_t bytes, std::align_val_t alignment) { return allocateOrThrow(bytes, alignment); }
+void *operator new[](std::size_t bytes, std::align_val_t alignment) { return allocateOrThrow(bytes, alignment); }
+
+void *operator new(std::size_t bytes, const std::nothrow_t &) noexcept { return allocate(bytes); }
+void *operator new[](std::size_t bytes, const std::nothrow_t &) noexcept { return allocate(bytes); }
+void *operator new(std::size_t bytes, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+    return allocate(bytes, alignment);
+}
+void *operator new[](std::size_t bytes, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+    return allocate(bytes, alignment);
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
@@ -0,0 +1,23 @@
+#include "allocations.hpp"
+
+#include <atomic>
+
+namespace allocations {
+namespace {
+std::atomic<bool> installed{false};
+
+// constant-initialised, so that operator new may touch it before any other thread_local is initialised
+thread_local Counts counts;
+}  // namespace
+
+bool counting() { return installed.load(std::memory_order_relaxed); }
+
+Counts current() { return counts; }
+
+void record(std::size_t bytes) {
+    counts.allocations++;
+    counts.bytes += bytes;
+}
+
+void install() { installed = true; }
+}  // namespace allocations
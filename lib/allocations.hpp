@@ -0,0 +1,34 @@
+#ifndef POTTSSAMPLER_ALLOCATIONS_H
+#define POTTSSAMPLER_ALLOCATIONS_H
+
+#include <cstddef>
+#include <cstdint>
+
+/// Heap allocation accounting. The counters are only advanced by the global
+/// operator new of allocation_hook.cpp, which is linked into the tests and
+/// benchmarks (the potts-allocation-hook target) and not into the library, so
+/// other programs pay nothing for it. Trace spans record the allocations made
+/// on their thread while they were open whenever the hook is linked.
+namespace allocations {
+
+struct Counts {
+    std::uint64_t allocations = 0;
+    std::uint64_t bytes       = 0;
+
+    Counts operator-(const Counts &other) const { return {allocations - other.allocations, bytes - other.bytes}; }
+};
+
+/// true if the counting operator new is linked into the program
+bool counting();
+
+/// the allocations made so far by the calling thread; always zero unless counting()
+Counts current();
+
+/// called by the counting operator new for every allocation
+void record(std::size_t bytes);
+
+/// called once by the counting operator new, as the program starts
+void install();
+}  // namespace allocations
+
+#endif  // POTTSSAMPLER_ALLOCATIONS_H
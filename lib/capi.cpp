@@ -0,0 +1,174 @@
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "potts.h"
+#include "random.hpp"
+#include "sampler.hpp"
+
+static_assert(sizeof(int) == sizeof(std::int32_t), "the C interface passes colours and vertices as int32_t");
+
+struct potts_sampler {
+    Graph graph;
+    Parameters parameters;
+    int numThreads = 1;
+
+    // when seeded, the ith sample drawn since seeding uses stream i
+    std::optional<std::uint64_t> seed{};
+    std::uint64_t drawn = 0;
+};
+
+namespace {
+thread_local std::string lastError;
+
+/// run f, translating exceptions into a status and the message of potts_last_error
+template<typename F>
+potts_status guard(F &&f) {
+    lastError.clear();
+    try {
+        return f();
+    } catch (const std::invalid_argument &err) {
+        lastError = err.what();
+        return POTTS_INVALID_ARGUMENT;
+    } catch (const std::exception &err) {
+        lastError = err.what();
+        return POTTS_ERROR;
+    } catch (...) {
+        lastError = "Unknown error.";
+        return POTTS_ERROR;
+    }
+}
+
+potts_status fail(potts_status status, std::string message) {
+    lastError = std::move(message);
+    return status;
+}
+
+/// draw numSamples samples into consecutive rows of out, split across the threads of the sampler
+template<typename Colour>
+potts_status sampleInto(potts_sampler *sampler, std::int32_t numSamples, Colour *out) {
+    if (!sampler || numSamples < 0 || (numSamples > 0 && !out)) {
+        return fail(POTTS_INVALID_ARGUMENT, "Expected a sampler, a non-negative count and an output buffer.");
+    }
+    if (std::numeric_limits<Colour>::max() < sampler->parameters.maxColours - 1) {
+        return fail(POTTS_COLOUR_OVERFLOW, "The output colour type cannot hold " +
+                                               std::to_string(sampler->parameters.maxColours) + " colours.");
+    }
+
+    // the calling thread samples too; seeding it must not leave its generator on the sampler's streams
+    struct RestoreGenerator {
+        const std::mt19937 generator = mersene_gen;
+        ~RestoreGenerator() { mersene_gen = generator; }
+    };
+    std::optional<RestoreGenerator> restore;
+    if (sampler->seed) {
+        restore.emplace();
+    }
+
+    return guard([&]() {
+        const std::size_t rowSize = sampler->graph.size();
+        const std::uint64_t first = sampler->drawn;
+
+        std::atomic<std::int32_t> next{0};
+        std::mutex mutex;
+        std::exception_ptr error;
+        auto worker = [&]() {
+            try {
+                for (std::int32_t i = next++; i < numSamples; i = next++) {
+                    if (sampler->seed) {
+                        seed(*sampler->seed, first + i);
+                    }
+                    // parameters were verified on creation, so a sample is always produced
+                    sample(sampler->parameters, sampler->graph, out + i * rowSize);
+                }
+            } catch (...) {
+                // stop handing out samples and rethrow on the calling thread
+                next = numSamples;
+                std::lock_guard<std::mutex> lock(mutex);
+                error = error ? error : std::current_exception();
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (int i = 1; i < std::min(sampler->numThreads, numSamples); i++) {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (auto &thread : threads) {
+            thread.join();
+        }
+
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        sampler->drawn += numSamples;
+        return POTTS_OK;
+    });
+}
+}  // namespace
+
+extern "C" {
+
+std::int32_t potts_abi_version(void) { return POTTS_ABI_VERSION; }
+
+const char *potts_last_error(void) { return lastError.c_str(); }
+
+potts_status potts_sampler_create(std::int32_t num_nodes, const std::int64_t *offsets, const std::int32_t *targets,
+                                  std::int32_t max_colours, double temperature, potts_sampler **sampler) {
+    if (!sampler) {
+        return fail(POTTS_INVALID_ARGUMENT, "Expected a location to store the sampler.");
+    }
+    *sampler = nullptr;
+
+    return guard([&]() {
+        Graph graph = Graph::view(num_nodes, offsets, targets);
+        Parameters parameters{num_nodes, max_colours, temperature};
+        if (!parameters.violations(graph).empty()) {
+            return fail(POTTS_UNSUPPORTED_PARAMETERS,
+                        "The parameters do not satisfy q > 2 * Delta, B < 1 and B > 1 - (q - 2 * Delta) / Delta.");
+        }
+
+        *sampler = new potts_sampler{.graph = std::move(graph), .parameters = parameters};
+        return POTTS_OK;
+    });
+}
+
+void potts_sampler_destroy(potts_sampler *sampler) { delete sampler; }
+
+potts_status potts_sampler_set_threads(potts_sampler *sampler, std::int32_t num_threads) {
+    if (!sampler || num_threads < 1) {
+        return fail(POTTS_INVALID_ARGUMENT, "Expected a sampler and at least one thread.");
+    }
+    sampler->numThreads = num_threads;
+    return POTTS_OK;
+}
+
+potts_status potts_sampler_set_seed(potts_sampler *sampler, std::uint64_t seed) {
+    if (!sampler) {
+        return fail(POTTS_INVALID_ARGUMENT, "Expected a sampler.");
+    }
+    sampler->seed  = seed;
+    sampler->drawn = 0;
+    return POTTS_OK;
+}
+
+potts_status potts_sample_int32(potts_sampler *sampler, std::int32_t num_samples, std::int32_t *out) {
+    return sampleInto(sampler, num_samples, out);
+}
+
+potts_status potts_sample_uint16(potts_sampler *sampler, std::int32_t num_samples, std::uint16_t *out) {
+    return sampleInto(sampler, num_samples, out);
+}
+
+potts_status potts_sample_uint8(potts_sampler *sampler, std::int32_t num_samples, std::uint8_t *out) {
+    return sampleInto(sampler, num_samples, out);
+}
+}
@@ -0,0 +1,201 @@
+#include "exact.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+namespace exact {
+
+std::size_t Distribution::index(const colouring_t &colouring) const {
+    std::size_t result = 0;
+    for (int v = numNodes - 1; v >= 0; v--) {
+        result = result * maxColours + colouring[v];
+    }
+    return result;
+}
+
+Distribution enumerate(const Parameters &parameters, const Graph &graph, int numThreads) {
+    const int n = graph.size();
+    const int q = parameters.maxColours;
+
+    // at most 2^26 colourings, i.e. 512MiB of probabilities
+    static constexpr std::size_t maxColourings = std::size_t{1} << 26;
+    std::size_t numColourings = 1;
+    for (int v = 0; v < n; v++) {
+        if (numColourings > maxColourings / q) {
+            throw std::invalid_argument("Too many colourings to enumerate.");
+        }
+        numColourings *= q;
+    }
+
+    int bits = 1;
+    while ((1 << bits) < q) {
+        bits++;
+    }
+    if (n * bits > 64) {
+        throw std::invalid_argument("A colouring does not fit in 64 bits.");
+    }
+    const std::uint64_t mask = (std::uint64_t{1} << bits) - 1;
+
+    // the bit offsets of the endpoints of each edge, in the original labels
+    std::vector<std::pair<int, int>> edges;
+    for (int v = 0; v < n; v++) {
+        for (int w : graph.getNeighbours(v)) {
+            if (w > v) {
+                edges.emplace_back(graph.toOriginal(v) * bits, graph.toOriginal(w) * bits);
+            }
+        }
+    }
+
+    std::vector<double> powers(edges.size() + 1);
+    for (int m = 0; m < powers.size(); m++) {
+        powers[m] = std::pow(static_cast<double>(parameters.temperature), m);
+    }
+
+    Distribution distribution{.numNodes = n, .maxColours = q, .probabilities = std::vector<double>(numColourings)};
+    numThreads = std::max(1, std::min<int>(numThreads, numColourings));
+
+    auto worker = [&](int t) {
+        const std::size_t first = numColourings * t / numThreads;
+        const std::size_t last  = numColourings * (t + 1) / numThreads;
+
+        // the colouring with index first, vertex v in bits [v * bits, (v + 1) * bits)
+        std::uint64_t word = 0;
+        std::size_t rest   = first;
+        for (int v = 0; v < n; v++) {
+            word |= static_cast<std::uint64_t>(rest % q) << (v * bits);
+            rest /= q;
+        }
+
+        for (std::size_t i = first; i < last; i++) {
+            int monochromatic = 0;
+            for (auto [a, b] : edges) {
+                monochromatic += (((word >> a) ^ (word >> b)) & mask) == 0;
+            }
+            distribution.probabilities[i] = powers[monochromatic];
+
+            // increment the base-q digits, carrying into the next vertex
+            for (int shift = 0; shift < n * bits; shift += bits) {
+                if (((word >> shift) & mask) + 1 < q) {
+                    word += std::uint64_t{1} << shift;
+                    break;
+                }
+                word &= ~(mask << shift);
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int t = 1; t < numThreads; t++) {
+        threads.emplace_back(worker, t);
+    }
+    worker(0);
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    // normalised in index order, so that the result does not depend on the number of threads
+    const double norm = std::accumulate(distribution.probabilities.begin(), distribution.probabilities.end(), 0.0);
+    for (double &probability : distribution.probabilities) {
+        probability /= norm;
+    }
+    return distribution;
+}
+
+/// upper tail of the chi-square distribution, using the Wilson-Hilferty normal approximation
+static double chiSquareTail(double statistic, int degreesOfFreedom) {
+    if (degreesOfFreedom <= 0) {
+        return 1;
+    }
+    const double k = degreesOfFreedom;
+    const double z = (std::cbrt(statistic / k) - (1 - 2 / (9 * k))) / std::sqrt(2 / (9 * k));
+    return 0.5 * std::erfc(z / std::sqrt(2.0));
+}
+
+/// E|X - N p| / N for X binomial with N trials and probability p, by De Moivre's formula
+/// 2 k C(N, k) p^k (1 - p)^(N - k + 1) with k = floor(N p) + 1; exact however small N p is
+static double meanAbsoluteDeviation(double numSamples, double p) {
+    if (p <= 0 || p >= 1) {
+        return 0;
+    }
+    const double k = std::floor(numSamples * p) + 1;
+    if (k > numSamples) {
+        return 0;
+    }
+    const double logDeviation = std::log(2 * k) + std::lgamma(numSamples + 1) - std::lgamma(k + 1) -
+                                std::lgamma(numSamples - k + 1) + k * std::log(p) +
+                                (numSamples - k + 1) * std::log1p(-p);
+    return std::exp(logDeviation) / numSamples;
+}
+
+/// compare the counts of numSamples samples in each cell against the probabilities of the cells
+static Result test(const std::vector<double> &probabilities, const std::vector<long long> &counts,
+                   double numSamples) {
+    // merge consecutive cells until each is expected to hold at least 5 samples
+    Result result{};
+    double binObserved = 0, binExpected = 0;
+    int cells = 0;
+    for (std::size_t i = 0; i < counts.size(); i++) {
+        const double p = probabilities[i];
+        binObserved += counts[i];
+        binExpected += numSamples * p;
+        if (binExpected >= 5 || i + 1 == counts.size()) {
+            result.chiSquare += binExpected > 0 ? std::pow(binObserved - binExpected, 2) / binExpected : 0;
+            binObserved = binExpected = 0;
+            cells++;
+        }
+
+        result.totalVariation += std::abs(counts[i] / numSamples - p) / 2;
+        result.expectedTotalVariation += meanAbsoluteDeviation(numSamples, p) / 2;
+    }
+
+    result.degreesOfFreedom = cells - 1;
+    result.pValue           = chiSquareTail(result.chiSquare, result.degreesOfFreedom);
+    return result;
+}
+
+Result test(const Distribution &distribution, const std::vector<colouring_t> &samples) {
+    std::vector<long long> counts(distribution.probabilities.size());
+    for (const colouring_t &colouring : samples) {
+        ++counts[distribution.index(colouring)];
+    }
+    return test(distribution.probabilities, counts, samples.size());
+}
+
+Result testMonochromaticEdges(const Distribution &distribution, const Graph &graph,
+                              const std::vector<colouring_t> &samples) {
+    // the edges in the original labels, in which colourings are indexed
+    std::vector<std::pair<int, int>> edges;
+    for (int v = 0; v < graph.size(); v++) {
+        for (int w : graph.getNeighbours(v)) {
+            if (w > v) {
+                edges.emplace_back(graph.toOriginal(v), graph.toOriginal(w));
+            }
+        }
+    }
+    auto monochromatic = [&edges](const colouring_t &colouring) {
+        return std::count_if(edges.begin(), edges.end(),
+                             [&colouring](auto edge) { return colouring[edge.first] == colouring[edge.second]; });
+    };
+
+    std::vector<double> probabilities(edges.size() + 1);
+    colouring_t colouring(distribution.numNodes);
+    for (std::size_t k = 0; k < distribution.probabilities.size(); k++) {
+        std::size_t index = k;
+        for (int &colour : colouring) {
+            colour = index % distribution.maxColours;
+            index /= distribution.maxColours;
+        }
+        probabilities[monochromatic(colouring)] += distribution.probabilities[k];
+    }
+
+    std::vector<long long> counts(edges.size() + 1);
+    for (const colouring_t &sample : samples) {
+        ++counts[monochromatic(sample)];
+    }
+    return test(probabilities, counts, samples.size());
+}
+}  // namespace exact
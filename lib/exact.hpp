@@ -0,0 +1,54 @@
+#ifndef POTTSSAMPLER_EXACT_H
+#define POTTSSAMPLER_EXACT_H
+
+#include <cstdint>
+#include <vector>
+
+#include "sampler.hpp"
+
+/// Exact enumeration of the anti-ferromagnetic Potts distribution on small
+/// graphs, used to check the output of the samplers statistically. A colouring
+/// has probability proportional to B^m, where m is its number of
+/// monochromatic edges.
+namespace exact {
+
+/// the probability of every colouring, indexed by index(colouring)
+struct Distribution {
+    int numNodes;
+    int maxColours;
+    std::vector<double> probabilities;
+
+    /// \return the colouring read as a base-q number, vertex 0 least significant
+    std::size_t index(const colouring_t &colouring) const;
+};
+
+/// enumerate all q^n colourings of graph, split into numThreads ranges; each thread steps
+/// through its range with the colouring bit-packed into a single word
+/// \throw std::invalid_argument if q^n colourings cannot be indexed or packed into 64 bits
+Distribution enumerate(const Parameters &, const Graph &, int numThreads);
+
+struct Result {
+    // Pearson's statistic, with consecutive colourings merged into cells expected to hold at least 5 samples
+    double chiSquare;
+    int degreesOfFreedom;
+
+    // the probability of a statistic at least as large under the exact distribution
+    double pValue;
+
+    // half the L1 distance between the empirical and exact distributions
+    double totalVariation;
+
+    // the expected total variation distance of as many exact samples, for scale; computed from the binomial
+    // count of each cell, so that it holds when most cells expect less than a sample
+    double expectedTotalVariation;
+};
+
+/// compare samples against the exact distribution
+Result test(const Distribution &, const std::vector<colouring_t> &samples);
+
+/// compare the number of monochromatic edges of the samples against its exact distribution, one cell per
+/// count; far fewer cells than test, so a small change of B is detected from as many samples
+Result testMonochromaticEdges(const Distribution &, const Graph &, const std::vector<colouring_t> &samples);
+}  // namespace exact
+
+#endif  // POTTSSAMPLER_EXACT_H
@@ -0,0 +1,107 @@
+#include "glauber.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace glauber {
+template<typename Colour>
+BasicChain<Colour> run(const Parameters &parameters, const Graph &graph, int numSamples,
+                       const SamplingOptions &options) {
+    std::uniform_int_distribution<int> uniformColour(0, parameters.maxColours - 1);
+
+    BasicChain<Colour> chain;
+    kernels::dispatch(parameters, graph, [&](auto kernel) {
+        using Kernel = decltype(kernel);
+
+        typename Kernel::state_t state{.parameters = parameters, .graph = graph};
+        state.colouring.resize(graph.size());
+        for (auto &colour : state.colouring) {
+            colour = uniformColour(mersene_gen);
+        }
+
+        for (int i = 0; i < options.sweeps; i++) {
+            sweep<Kernel>(state);
+        }
+
+        for (int s = 0; s < numSamples; s++) {
+            for (int i = 0; i < std::max(options.thinning, 1); i++) {
+                sweep<Kernel>(state);
+            }
+            chain.colourings.emplace_back(graph.toOriginal<Colour>(state.colouring));
+            chain.energies.emplace_back(energy(graph, state.colouring));
+        }
+    });
+    return chain;
+}
+
+template BasicChain<std::uint8_t> run(const Parameters &, const Graph &, int, const SamplingOptions &);
+template BasicChain<std::uint16_t> run(const Parameters &, const Graph &, int, const SamplingOptions &);
+template BasicChain<int> run(const Parameters &, const Graph &, int, const SamplingOptions &);
+
+double autocorrelationTime(const std::vector<double> &series) {
+    const int n = series.size();
+    if (n < 2) {
+        return 1;
+    }
+
+    const double mean = std::accumulate(series.begin(), series.end(), 0.0) / n;
+    auto autocovariance = [&](int k) {
+        double total = 0;
+        for (int i = 0; i + k < n; i++) {
+            total += (series[i] - mean) * (series[i + k] - mean);
+        }
+        return total / n;
+    };
+
+    const double variance = autocovariance(0);
+    if (variance == 0) {
+        return 1;
+    }
+
+    double tau = 1;
+    for (int k = 1; k < n && k < 5 * tau; k++) {
+        tau += 2 * autocovariance(k) / variance;
+    }
+    return std::max(tau, 1.0);
+}
+
+double gelmanRubin(const std::vector<std::vector<double>> &chains) {
+    const int m = chains.size();
+    const int n = m ? std::min_element(chains.begin(), chains.end(),
+                                       [](const auto &a, const auto &b) { return a.size() < b.size(); })
+                          ->size()
+                    : 0;
+    if (m < 2 || n < 2) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+
+    std::vector<double> means(m);
+    double within = 0;
+    for (int j = 0; j < m; j++) {
+        means[j] = std::accumulate(chains[j].begin(), chains[j].begin() + n, 0.0) / n;
+
+        double variance = 0;
+        for (int i = 0; i < n; i++) {
+            variance += (chains[j][i] - means[j]) * (chains[j][i] - means[j]);
+        }
+        within += variance / (n - 1);
+    }
+    within /= m;
+
+    const double grandMean = std::accumulate(means.begin(), means.end(), 0.0) / m;
+    double between = 0;
+    for (double mean : means) {
+        between += (mean - grandMean) * (mean - grandMean);
+    }
+    between *= static_cast<double>(n) / (m - 1);
+
+    if (within == 0) {
+        return between == 0 ? 1 : std::numeric_limits<double>::infinity();
+    }
+
+    const double pooled = (n - 1.0) / n * within + between / n;
+    return std::sqrt(pooled / within);
+}
+}  // namespace glauber
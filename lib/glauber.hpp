@@ -0,0 +1,59 @@
+#ifndef POTTSSAMPLER_GLAUBER_H
+#define POTTSSAMPLER_GLAUBER_H
+
+#include <vector>
+
+#include "kernel.hpp"
+#include "random.hpp"
+#include "sampler.hpp"
+#include "state.hpp"
+
+/// Heat-bath Glauber dynamics. Each step recolours a vertex from the
+/// conditional distribution given its neighbours, i.e. with weights B^{m_c}.
+/// Unlike the perfect sampler, the output is only approximately distributed
+/// according to the Potts model.
+namespace glauber {
+
+template<typename Colour>
+struct BasicChain {
+    std::vector<basic_colouring_t<Colour>> colourings;
+
+    // number of monochromatic edges of each sample
+    std::vector<double> energies;
+};
+
+using Chain = BasicChain<int>;
+
+/// recolour every vertex once, in order
+template<typename Kernel>
+void sweep(typename Kernel::state_t &state) {
+    for (int v = 0; v < state.graph.size(); v++) {
+        state.colouring[v] = sampleFromDist(Kernel::neighbourhoodWeights(state, v));
+    }
+}
+
+/// \return the number of monochromatic edges in the colouring
+template<typename Colour = int>
+int energy(const Graph &graph, const BasicStateColouring<Colour> &colouring) {
+    int count = 0;
+    for (int v = 0; v < graph.size(); v++) {
+        for (int w : graph.getNeighbours(v)) {
+            count += w > v && colouring[v] == colouring[w];
+        }
+    }
+    return count;
+}
+
+/// run a single chain from a uniformly random colouring
+/// \param numSamples the number of samples to record after burn-in
+template<typename Colour = int>
+BasicChain<Colour> run(const Parameters &, const Graph &, int numSamples, const SamplingOptions &);
+
+/// integrated autocorrelation time of a series, using Sokal's adaptive window
+double autocorrelationTime(const std::vector<double> &series);
+
+/// Gelman-Rubin potential scale reduction factor, truncating chains to the shortest
+double gelmanRubin(const std::vector<std::vector<double>> &chains);
+}  // namespace glauber
+
+#endif  // POTTSSAMPLER_GLAUBER_H
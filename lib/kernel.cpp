@@ -0,0 +1,40 @@
+#include "kernel.hpp"
+
+#include "update.hpp"
+
+namespace kernels {
+namespace {
+thread_local std::vector<int> counts;
+thread_local std::vector<long double> neighbourhood, fixed;
+}  // namespace
+
+template<typename Colour>
+const typename Dynamic<Colour>::weights_t &Dynamic<Colour>::neighbourhoodWeights(const state_t &state, int v) {
+    counts.assign(state.parameters.maxColours, 0);
+    for (int neighbour : state.graph.getNeighbours(v)) {
+        ++counts[state.colouring[neighbour]];
+    }
+
+    neighbourhood.resize(counts.size());
+    for (int c{}; c < counts.size(); ++c) {
+        neighbourhood[c] = pow(state.parameters.temperature, counts[c]);
+    }
+    return neighbourhood;
+}
+
+template<typename Colour>
+const typename Dynamic<Colour>::weights_t &Dynamic<Colour>::fixedColourWeights(const state_t &state, int v) {
+    fixed.assign(state.parameters.maxColours, 0);
+    const BoundingList &unfixed = state.neighbourCounts.unfixedColours(v);
+    for (int c{}; c < unfixed.size(); ++c) {
+        if (!unfixed[c]) {
+            fixed[c] = pow(state.parameters.temperature, state.neighbourCounts.m_Q(v, c));
+        }
+    }
+    return fixed;
+}
+
+template struct Dynamic<std::uint8_t>;
+template struct Dynamic<std::uint16_t>;
+template struct Dynamic<int>;
+}  // namespace kernels
@@ -0,0 +1,138 @@
+#ifndef POTTSSAMPLER_KERNEL_H
+#define POTTSSAMPLER_KERNEL_H
+
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "kernel_list.hpp"
+#include "maths.hpp"
+#include "sampler.hpp"
+#include "state.hpp"
+
+/// The numerical kernels used by the update classes. A kernel supplies the
+/// neighbourhood weights B^{m_c} and the model constants q and Delta. The
+/// generic kernel works for any model; the fixed kernels are specialised on
+/// (q, Delta) so that the colour loops are unrolled over fixed-size arrays.
+namespace kernels {
+
+namespace detail {
+template<typename F, std::size_t... I>
+constexpr void unroll(F &&f, std::index_sequence<I...>) {
+    (f(static_cast<int>(I)), ...);
+}
+}  // namespace detail
+
+/// call f(0), ..., f(N - 1), fully unrolled
+template<int N, typename F>
+constexpr void unroll(F &&f) {
+    detail::unroll(f, std::make_index_sequence<N>{});
+}
+
+/// \return true if the colours 0, ..., maxColours - 1 fit in Colour
+template<typename Colour>
+constexpr bool fits(int maxColours) {
+    return maxColours - 1 <= static_cast<long long>(std::numeric_limits<Colour>::max());
+}
+
+/// the narrowest unsigned type holding the colours 0, ..., Q - 1
+template<int Q>
+using colour_for_t = std::conditional_t<fits<std::uint8_t>(Q), std::uint8_t,
+                                        std::conditional_t<fits<std::uint16_t>(Q), std::uint16_t, int>>;
+
+/// generic kernel, q and Delta are only known at runtime
+/// \tparam Colour the integer type the colouring is stored in
+template<typename Colour = int>
+struct Dynamic {
+    using colour_t  = Colour;
+    using state_t   = BasicState<Colour>;
+    using weights_t = std::vector<long double>;
+
+    static int maxColours(const state_t &state) { return state.parameters.maxColours; }
+
+    static int maxDegree(const state_t &state) { return state.graph.getMaxDegree(); }
+
+    /// the weights are written to a buffer of the calling thread, reused by the next call, so that
+    /// steady-state updates do not allocate
+    /// \return the weights B^{m_c}, where m_c is the number of neighbours of v coloured c
+    static const weights_t &neighbourhoodWeights(const state_t &, int v);
+
+    /// \return the weights B^{m_Q(c)} for the colours c fixed around v, zero elsewhere
+    /// \sa neighbourhoodWeights, whose buffer is separate
+    static const weights_t &fixedColourWeights(const state_t &, int v);
+};
+
+/// kernel specialised on the number of colours Q and the maximum degree Delta
+template<int Q, int Delta>
+struct Fixed {
+    static_assert(Q > 2 * Delta, "a kernel must satisfy q > 2 * Delta");
+
+    using colour_t  = colour_for_t<Q>;
+    using state_t   = BasicState<colour_t>;
+    using weights_t = std::array<long double, Q>;
+    using counts_t  = std::array<int, Q>;
+
+    static constexpr int maxColours(const state_t &) { return Q; }
+
+    static constexpr int maxDegree(const state_t &) { return Delta; }
+
+    static weights_t neighbourhoodWeights(const state_t &state, int v) {
+        counts_t counts{};
+        for (int neighbour : state.graph.getNeighbours(v)) {
+            ++counts[state.colouring[neighbour]];
+        }
+        return toWeights(state.parameters.temperature, counts, [](int) { return true; });
+    }
+
+    static weights_t fixedColourWeights(const state_t &state, int v) {
+        const BoundingList &unfixed = state.neighbourCounts.unfixedColours(v);
+
+        counts_t counts;
+        unroll<Q>([&](int c) { counts[c] = state.neighbourCounts.m_Q(v, c); });
+        return toWeights(state.parameters.temperature, counts, [&unfixed](int c) { return !unfixed[c]; });
+    }
+
+   private:
+    /// map the counts c -> B^c, using that no count exceeds Delta
+    template<typename Mask>
+    static weights_t toWeights(long double temperature, const counts_t &counts, Mask &&mask) {
+        std::array<long double, Delta + 1> powers;
+        maths::powers(temperature, powers);
+
+        weights_t weights;
+        unroll<Q>([&](int c) {
+            assert(counts[c] <= Delta);
+            weights[c] = mask(c) ? powers[counts[c]] : 0.0L;
+        });
+        return weights;
+    }
+};
+
+/// call f with the fixed kernel matching (q, Delta) if one was compiled in
+/// (see POTTS_KERNELS), otherwise with the generic kernel over the narrowest
+/// colour type holding q colours
+template<typename F>
+decltype(auto) dispatch(const Parameters &parameters, const Graph &graph, F &&f) {
+#define POTTS_KERNEL(q, delta)                                                   \
+    if (parameters.maxColours == (q) && graph.getMaxDegree() == (delta)) { \
+        return f(Fixed<q, delta>{});                                             \
+    }
+    POTTS_KERNEL_LIST
+#undef POTTS_KERNEL
+
+    if (fits<std::uint8_t>(parameters.maxColours)) {
+        return f(Dynamic<std::uint8_t>{});
+    }
+    if (fits<std::uint16_t>(parameters.maxColours)) {
+        return f(Dynamic<std::uint16_t>{});
+    }
+    return f(Dynamic<int>{});
+}
+}  // namespace kernels
+
+#endif  // POTTSSAMPLER_KERNEL_H
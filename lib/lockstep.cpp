@@ -0,0 +1,503 @@
+#include "lockstep.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+#include "maths.hpp"
+#include "random.hpp"
+#include "state.hpp"
+#include "trace.hpp"
+
+namespace lockstep {
+namespace {
+/// a set of at most maxColours colours, one bit per colour
+using colours_t = std::uint64_t;
+
+/// a value for each lane
+template<typename T>
+using PerLane = std::array<T, lanes>;
+
+int count(colours_t set) { return __builtin_popcountll(set); }
+
+int lowest(colours_t set) { return __builtin_ctzll(set); }
+
+int highest(colours_t set) { return 63 - __builtin_clzll(set); }
+
+bool isSingleton(colours_t set) { return set && !(set & (set - 1)); }
+
+/// all ones if condition holds, all zeros otherwise, to select bits without a branch
+colours_t mask(bool condition) { return -static_cast<colours_t>(condition); }
+
+/// \return the kth smallest colour of set, counting from 0, by halving the word six times whatever the set
+int select(colours_t set, int k) {
+    int result = 0;
+    for (int width = 32; width > 0; width /= 2) {
+        const colours_t low = set & ((colours_t{1} << width) - 1);
+        const int inLow     = count(low);
+        const bool high     = k >= inLow;
+        k -= high ? inLow : 0;
+        set = high ? set >> width : low;
+        result += high ? width : 0;
+    }
+    return result;
+}
+
+/// the randomness of a compress update, from which its colour is recomputed during replay
+struct Compress {
+    int v;
+    int c1;
+    colours_t A;
+    double gamma;
+    double tau;
+};
+
+/// the randomness of a contract update, from which its colour is recomputed during replay
+struct Contract {
+    int v;
+    int c1;
+    int c2;
+    int unfixedCount;
+    double gamma;
+};
+
+/// the updates of one epoch of every lane, lane-interleaved: the jth update of lane l is at j * lanes + l; every
+/// lane makes the same number of updates in an epoch, and in phase one at the same vertices
+struct Epoch {
+    std::vector<Compress> phaseOneHistory;
+    std::vector<Contract> phaseTwoHistory;
+};
+
+class Engine {
+   public:
+    Engine(const Parameters &parameters, const Graph &graph)
+        : graph(graph),
+          n(graph.size()),
+          q(parameters.maxColours),
+          delta(graph.getMaxDegree()),
+          temperature(parameters.temperature),
+          full(q == 64 ? ~colours_t{} : (colours_t{1} << q) - 1),
+          phaseTwoIters(std::max<std::int64_t>(getPhaseTwoIters(graph, parameters), 0)),
+          colours(n * lanes),
+          boundingLists(n * lanes),
+          counts(q * lanes),
+          powers(graph.getMaxDegree() + 1) {
+        maths::powers(temperature, powers);
+    }
+
+    template<typename Colour>
+    void run(int numSamples, BasicSamples<Colour> &samples) {
+        int started = 0;
+        for (int l = 0; l < lanes; l++) {
+            restart(l, 0);
+            active[l] = started < numSamples;
+            started += active[l];
+        }
+
+        // every lane runs every epoch, so that the updates are computed for all lanes at once; lanes with no
+        // samples left are masked off, and only their results are discarded
+        for (int t = 0; anyActive(); t++) {
+            trace::Span span("lockstep epoch");
+            span.set("epoch", t);
+
+            beginEpoch(t);
+            phaseOne();
+            phaseTwo();
+
+            // the lanes which coalesced are replayed together, then refilled while samples remain
+            PerLane<bool> coalesced;
+            for (int l = 0; l < lanes; l++) {
+                coalesced[l] = active[l] && !nonSingleton[l];
+            }
+            if (std::none_of(coalesced.begin(), coalesced.end(), [](bool c) { return c; })) {
+                continue;
+            }
+
+            replay(t, coalesced);
+            for (int l = 0; l < lanes; l++) {
+                if (!coalesced[l]) {
+                    continue;
+                }
+                output(l, t, samples);
+                restart(l, t + 1);
+                active[l] = started < numSamples;
+                started += active[l];
+            }
+        }
+    }
+
+   private:
+    bool anyActive() const { return std::any_of(active.begin(), active.end(), [](bool a) { return a; }); }
+
+    double unit() { return unitDist(mersene_gen); }
+
+    int uniform(int k) { return std::uniform_int_distribution<int>(0, k - 1)(mersene_gen); }
+
+    /// start a fresh sample in lane l at epoch t, with every bounding list full
+    void restart(int l, int t) {
+        start[l]        = t;
+        nonSingleton[l] = n;
+        for (int v = 0; v < n; v++) {
+            boundingLists[v * lanes + l] = full;
+        }
+    }
+
+    /// the epoch t of every lane, reusing the buffers of the epochs no active lane will replay
+    Epoch &epoch(int t) { return history[t - first]; }
+
+    void beginEpoch(int t) {
+        int oldest = t;
+        for (int l = 0; l < lanes; l++) {
+            oldest = active[l] ? std::min(oldest, start[l]) : oldest;
+        }
+        for (; first < oldest && !history.empty(); first++) {
+            spare.push_back(std::move(history.front()));
+            history.erase(history.begin());
+        }
+        first = history.empty() ? t : first;
+
+        if (spare.empty()) {
+            spare.emplace_back();
+        }
+        history.push_back(std::move(spare.back()));
+        spare.pop_back();
+        history.back().phaseOneHistory.clear();
+        history.back().phaseTwoHistory.clear();
+    }
+
+    /// replace the bounding list of v in every lane
+    void setBoundingLists(const PerLane<int> &v, const PerLane<colours_t> &boundingList) {
+        for (int l = 0; l < lanes; l++) {
+            colours_t &previous = boundingLists[v[l] * lanes + l];
+            nonSingleton[l] += !isSingleton(boundingList[l]) - !isSingleton(previous);
+            previous = boundingList[l];
+        }
+    }
+
+    /// the neighbours of a vertex in each lane; the update loops run over Delta slots, those past the degree of
+    /// the vertex of a lane reading the vertex itself and being masked off
+    struct Neighbourhoods {
+        PerLane<const int *> first;
+        PerLane<int> degree;
+        PerLane<int> self;
+
+        int at(int l, int k) const { return k < degree[l] ? first[l][k] : self[l]; }
+    };
+
+    Neighbourhoods neighbourhoods(const PerLane<int> &v) const {
+        Neighbourhoods result;
+        for (int l = 0; l < lanes; l++) {
+            const Graph::Neighbours neighbours = graph.getNeighbours(v[l]);
+            result.first[l]                    = neighbours.begin();
+            result.degree[l]                   = neighbours.size();
+            result.self[l]                     = v[l];
+        }
+        return result;
+    }
+
+    /// every vertex in order: compress updates on the greater neighbours, then a contract update
+    void phaseOne() {
+        PerLane<colours_t> A;
+        for (int v = 0; v < n; v++) {
+            // \sa queries::getA
+            A.fill(0);
+            for (int u : graph.getNeighbours(v)) {
+                if (u > v) {
+                    const colours_t *lists = &boundingLists[u * lanes];
+                    for (int l = 0; l < lanes; l++) {
+                        A[l] |= lists[l];
+                    }
+                }
+            }
+            for (int l = 0; l < lanes; l++) {
+                maths::fitA(A[l], q, delta);
+            }
+
+            for (int w : graph.getNeighbours(v)) {
+                if (w > v) {
+                    compress(w, A);
+                }
+            }
+
+            PerLane<int> vertex;
+            vertex.fill(v);
+            contract(vertex);
+        }
+    }
+
+    /// contract updates at uniformly random vertices, drawn independently for each lane
+    void phaseTwo() {
+        PerLane<int> v;
+        for (std::int64_t i = 0; i < phaseTwoIters; i++) {
+            for (int l = 0; l < lanes; l++) {
+                v[l] = uniform(n);
+            }
+            contract(v);
+        }
+    }
+
+    /// \sa CompressUpdate
+    void compress(int w, const PerLane<colours_t> &A) {
+        std::vector<Compress> &updates = history.back().phaseOneHistory;
+        PerLane<int> vertex;
+        PerLane<colours_t> boundingList;
+        for (int l = 0; l < lanes; l++) {
+            const int c1 = select(full & ~A[l], uniform(q - delta));
+            updates.push_back(Compress{w, c1, A[l], unit(), unit()});
+            vertex[l]       = w;
+            boundingList[l] = A[l] | colours_t{1} << c1;
+        }
+        setBoundingLists(vertex, boundingList);
+    }
+
+    /// \sa ContractUpdate
+    void contract(const PerLane<int> &v) {
+        const Neighbourhoods neighbours = neighbourhoods(v);
+
+        // the union of the bounding lists around v which are not singletons, and the number of neighbours
+        // fixed to each colour, m_Q
+        PerLane<colours_t> unfixed{};
+        for (int k = 0; k < delta; k++) {
+            for (int l = 0; l < lanes; l++) {
+                const colours_t boundingList = boundingLists[neighbours.at(l, k) * lanes + l];
+                const bool neighbour         = k < neighbours.degree[l];
+                const bool fixed             = isSingleton(boundingList);
+                unfixed[l] |= boundingList & mask(neighbour && !fixed);
+                counts[lowest(boundingList) * lanes + l] += neighbour && fixed;
+            }
+        }
+
+        // c2 is drawn with weight B^{m_Q(c)} from the colours outside unfixed, as in sampleC2
+        PerLane<double> u;
+        for (int l = 0; l < lanes; l++) {
+            u[l] = unit();
+        }
+        PerLane<int> c2 = sample(u, [&](int l, int c) { return maths::contains(unfixed[l], c) ? 0.0 : weight(l, c); });
+        for (int l = 0; l < lanes; l++) {
+            // rounding may leave no partial sum above the target, and then c2 is the last colour it may take
+            c2[l] = std::min(c2[l], highest((full & ~unfixed[l]) | 1));
+        }
+        clear(neighbours, boundingLists, [](colours_t boundingList) { return lowest(boundingList); });
+
+        std::vector<Contract> &updates = history.back().phaseTwoHistory;
+        PerLane<colours_t> boundingList;
+        for (int l = 0; l < lanes; l++) {
+            const int unfixedCount = count(unfixed[l]);
+            // c1 is 0 when there are no unfixed colours, as then it is never chosen
+            const int c1 = select(unfixed[l] | !unfixed[l], uniform(std::max(unfixedCount, 1)));
+            const double gamma = unit();
+            updates.push_back(Contract{v[l], c1, c2[l], unfixedCount, gamma});
+
+            const bool onlyC2 = gamma > maths::boundingListCutoff(unfixedCount, q, delta, temperature);
+            boundingList[l]   = colours_t{1} << c2[l] | (colours_t{1} << c1 & mask(unfixedCount && !onlyC2));
+        }
+        setBoundingLists(v, boundingList);
+    }
+
+    /// B^{m}, for the count m of colour c around the vertex of lane l last counted
+    double weight(int l, int c) const { return powers[counts[c * lanes + l]]; }
+
+    /// draw a colour in each lane with probability proportional to weight(l, c), by the inverse transform of u[l]
+    /// \sa maths::sampleWeighted, whose result is the number of colours whose partial sum is at most u[l] times
+    /// the total weight; q in a lane where rounding left every partial sum at or below it
+    template<typename Weight>
+    PerLane<int> sample(const PerLane<double> &u, Weight &&weight) const {
+        PerLane<double> target{}, partial{};
+        PerLane<int> result{};
+        for (int c = 0; c < q; c++) {
+            for (int l = 0; l < lanes; l++) {
+                target[l] += weight(l, c);
+            }
+        }
+        for (int l = 0; l < lanes; l++) {
+            target[l] *= u[l];
+        }
+        for (int c = 0; c < q; c++) {
+            for (int l = 0; l < lanes; l++) {
+                partial[l] += weight(l, c);
+                result[l] += partial[l] <= target[l];
+            }
+        }
+        return result;
+    }
+
+    /// zero the counts of the colours colourOf(values[u]) around the vertices of neighbours
+    template<typename Values, typename ColourOf>
+    void clear(const Neighbourhoods &neighbours, const Values &values, ColourOf &&colourOf) {
+        for (int k = 0; k < delta; k++) {
+            for (int l = 0; l < lanes; l++) {
+                counts[colourOf(values[neighbours.at(l, k) * lanes + l]) * lanes + l] = 0;
+            }
+        }
+    }
+
+    /// count the colours around the vertex of each lane into counts
+    /// \return the sum over all colours c of B^{m_c}, for each lane
+    PerLane<double> countNeighbourhoods(const Neighbourhoods &neighbours) {
+        for (int k = 0; k < delta; k++) {
+            for (int l = 0; l < lanes; l++) {
+                counts[colours[neighbours.at(l, k) * lanes + l] * lanes + l] += k < neighbours.degree[l];
+            }
+        }
+
+        PerLane<double> norm{};
+        for (int c = 0; c < q; c++) {
+            for (int l = 0; l < lanes; l++) {
+                norm[l] += weight(l, c);
+            }
+        }
+        return norm;
+    }
+
+    /// set the colours of the lanes in replaying to those chosen by the compress updates given the colouring
+    /// \sa CompressUpdate::getNewColour
+    void colour(const Compress *updates, const PerLane<bool> &replaying) {
+        PerLane<int> v;
+        for (int l = 0; l < lanes; l++) {
+            v[l] = updates[l].v;
+        }
+        const Neighbourhoods neighbours = neighbourhoods(v);
+        const PerLane<double> norm      = countNeighbourhoods(neighbours);
+
+        PerLane<bool> fromA;
+        PerLane<double> tau;
+        for (int l = 0; l < lanes; l++) {
+            fromA[l] = updates[l].gamma >= maths::compressCutoff(weight(l, updates[l].c1), q, delta, norm[l]);
+            tau[l]   = updates[l].tau;
+        }
+
+        // sampling from A is rare, so it is skipped when no lane needs it
+        PerLane<int> sampled{};
+        if (std::any_of(fromA.begin(), fromA.end(), [](bool a) { return a; })) {
+            sampled = sample(tau, [&](int l, int c) { return maths::contains(updates[l].A, c) ? weight(l, c) : 0.0; });
+        }
+        for (int l = 0; l < lanes; l++) {
+            if (replaying[l] && fromA[l] && sampled[l] == q) {
+                throw std::runtime_error("No sample generated from A (likely caused by rounding error).");
+            }
+        }
+
+        clear(neighbours, colours, [](std::uint8_t colour) { return colour; });
+        for (int l = 0; l < lanes; l++) {
+            std::uint8_t &colour = colours[v[l] * lanes + l];
+            colour               = replaying[l] ? (fromA[l] ? sampled[l] : updates[l].c1) : colour;
+        }
+    }
+
+    /// set the colours of the lanes in replaying to those chosen by the contract updates given the colouring
+    /// \sa ContractUpdate::getNewColour
+    void colour(const Contract *updates, const PerLane<bool> &replaying) {
+        PerLane<int> v;
+        for (int l = 0; l < lanes; l++) {
+            v[l] = updates[l].v;
+        }
+        const Neighbourhoods neighbours = neighbourhoods(v);
+        const PerLane<double> norm      = countNeighbourhoods(neighbours);
+
+        PerLane<int> result;
+        for (int l = 0; l < lanes; l++) {
+            const Contract &update = updates[l];
+            const double cutoff    = maths::contractCutoff(weight(l, update.c1), update.unfixedCount, norm[l]);
+            result[l]              = update.gamma < cutoff ? update.c1 : update.c2;
+        }
+
+        clear(neighbours, colours, [](std::uint8_t colour) { return colour; });
+        for (int l = 0; l < lanes; l++) {
+            std::uint8_t &colour = colours[v[l] * lanes + l];
+            colour               = replaying[l] ? result[l] : colour;
+        }
+    }
+
+    /// \sa updateColourWithEpoch, applied to the epochs of the coalesced lanes from the second last to the first,
+    /// starting from their coalesced bounding chains; the lanes replay together, each masked off once its own
+    /// epochs run out, and as in the scalar sampler, the forward pass evaluates no colours
+    void replay(int t, const PerLane<bool> &coalesced) {
+        trace::Span span("replay");
+        int oldest = t;
+        for (int l = 0; l < lanes; l++) {
+            oldest = coalesced[l] ? std::min(oldest, start[l]) : oldest;
+        }
+        span.set("epochs", t - oldest + 1);
+
+        // the colours are only read by the replay, so those of the other lanes are left as they are
+        for (int v = 0; v < n; v++) {
+            for (int l = 0; l < lanes; l++) {
+                std::uint8_t &colour = colours[v * lanes + l];
+                colour               = coalesced[l] ? lowest(boundingLists[v * lanes + l]) : colour;
+            }
+        }
+
+        for (int e = t - 1; e >= oldest; e--) {
+            PerLane<bool> replaying;
+            for (int l = 0; l < lanes; l++) {
+                replaying[l] = coalesced[l] && e >= start[l];
+            }
+
+            const Epoch &updates = epoch(e);
+            for (std::size_t j = 0; j < updates.phaseOneHistory.size(); j += lanes) {
+                colour(&updates.phaseOneHistory[j], replaying);
+            }
+            for (std::size_t j = 0; j < updates.phaseTwoHistory.size(); j += lanes) {
+                colour(&updates.phaseTwoHistory[j], replaying);
+            }
+        }
+    }
+
+    template<typename Colour>
+    void output(int l, int t, BasicSamples<Colour> &samples) {
+        basic_colouring_t<Colour> &colouring = samples.colourings.emplace_back(n);
+        for (int v = 0; v < n; v++) {
+            colouring[graph.toOriginal(v)] = colours[v * lanes + l];
+        }
+        samples.epochs.emplace_back(t - start[l] + 1);
+    }
+
+    const Graph &graph;
+    const int n, q, delta;
+    const double temperature;
+    const colours_t full;
+    const std::int64_t phaseTwoIters;
+
+    // lane-interleaved: the colour and bounding list of v in lane l are at v * lanes + l
+    std::vector<std::uint8_t> colours;
+    std::vector<colours_t> boundingLists;
+
+    // whether each lane has a sample to finish, the epoch at which its sample started, and the number of its
+    // vertices whose bounding list is not a singleton
+    PerLane<bool> active{};
+    PerLane<int> start{};
+    PerLane<int> nonSingleton{};
+
+    // the epochs from first on, as long as an active lane may replay them, and the buffers of older ones
+    int first = 0;
+    std::vector<Epoch> history;
+    std::vector<Epoch> spare;
+
+    // scratch counts of each colour c around the vertex of each lane l, at c * lanes + l; all zero between updates
+    std::vector<int> counts;
+
+    // B^k for k = 0, ..., Delta
+    std::vector<double> powers;
+
+    std::uniform_real_distribution<double> unitDist{0.0, 1.0};
+};
+}  // namespace
+
+template<typename Colour>
+void run(const Parameters &parameters, const Graph &graph, int numSamples, BasicSamples<Colour> &samples) {
+    if (parameters.maxColours > maxColours) {
+        throw std::invalid_argument("The lockstep engine supports at most " + std::to_string(maxColours) +
+                                    " colours.");
+    }
+
+    Engine(parameters, graph).run(numSamples, samples);
+}
+
+template void run<std::uint8_t>(const Parameters &, const Graph &, int, BasicSamples<std::uint8_t> &);
+template void run<std::uint16_t>(const Parameters &, const Graph &, int, BasicSamples<std::uint16_t> &);
+template void run<int>(const Parameters &, const Graph &, int, BasicSamples<int> &);
+}  // namespace lockstep
@@ -0,0 +1,33 @@
+#ifndef POTTSSAMPLER_LOCKSTEP_H
+#define POTTSSAMPLER_LOCKSTEP_H
+
+#include "sampler.hpp"
+
+/// A perfect sampler which advances several independent samples ("lanes")
+/// on the same graph in lockstep, epoch by epoch. The state of all lanes is
+/// stored lane-interleaved: the colour of v in lane l is colours[v * lanes + l],
+/// and its bounding list is the colour mask boundingLists[v * lanes + l]. Every
+/// update, forward and in replay, is a loop over the lanes innermost: each lane
+/// reads its own vertex, neighbour slots past its degree are masked off, and the
+/// colours are chosen from the colour masks by selection without branches. Phase
+/// one runs all lanes at the same vertex; phase two draws its vertices
+/// independently for each lane. The lanes whose bounding chains coalesce in an
+/// epoch replay their histories together and are refilled with fresh samples at
+/// the next epoch; lanes with no samples left still compute, and are discarded.
+/// Each lane follows the steps of the scalar sampler, so its samples have the
+/// same distribution.
+namespace lockstep {
+
+/// the number of samples advanced together
+constexpr int lanes = 8;
+
+/// the largest number of colours supported, so that a bounding list fits in a word
+constexpr int maxColours = 64;
+
+/// append numSamples perfect samples, and the number of epochs each ran, to samples
+/// \throw std::invalid_argument if parameters.maxColours > maxColours
+template<typename Colour>
+void run(const Parameters &parameters, const Graph &graph, int numSamples, BasicSamples<Colour> &samples);
+}  // namespace lockstep
+
+#endif  // POTTSSAMPLER_LOCKSTEP_H
@@ -0,0 +1,126 @@
+#include "mapped.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+static std::runtime_error systemError(const std::string &what) {
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+std::size_t pageSize() {
+    static const std::size_t size = sysconf(_SC_PAGESIZE);
+    return size;
+}
+
+std::size_t pageAlign(std::size_t bytes) { return (bytes + pageSize() - 1) / pageSize() * pageSize(); }
+
+/*************************************
+ * Mapped File
+ *************************************/
+
+std::shared_ptr<MappedFile> MappedFile::open(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw systemError("Could not open " + path);
+    }
+
+    struct stat status {};
+    if (fstat(fd, &status) != 0 || status.st_size == 0) {
+        ::close(fd);
+        throw systemError("Could not read the size of " + path);
+    }
+
+    void *address = mmap(nullptr, status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (address == MAP_FAILED) {
+        throw systemError("Could not map " + path);
+    }
+
+    return std::shared_ptr<MappedFile>(new MappedFile(address, status.st_size));
+}
+
+std::shared_ptr<MappedFile> MappedFile::create(const std::string &directory, std::size_t size) {
+    std::string path = directory + "/potts-XXXXXX";
+    int fd           = mkstemp(path.data());
+    if (fd < 0) {
+        throw systemError("Could not create a file in " + directory);
+    }
+    unlink(path.c_str());
+
+    const std::size_t length = pageAlign(std::max<std::size_t>(size, 1));
+    if (ftruncate(fd, length) != 0) {
+        ::close(fd);
+        throw systemError("Could not resize " + path);
+    }
+
+    void *address = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (address == MAP_FAILED) {
+        throw systemError("Could not map " + path);
+    }
+
+    return std::shared_ptr<MappedFile>(new MappedFile(address, length));
+}
+
+MappedFile::~MappedFile() { munmap(address, length); }
+
+/*************************************
+ * Advice
+ *************************************/
+
+void advise(const void *data, std::size_t size, Access access) {
+    // madvise requires a page-aligned start
+    auto start       = reinterpret_cast<std::uintptr_t>(data) / pageSize() * pageSize();
+    std::size_t span = reinterpret_cast<std::uintptr_t>(data) + size - start;
+
+    int advice = access == Access::SEQUENTIAL ? MADV_SEQUENTIAL : access == Access::RANDOM ? MADV_RANDOM : MADV_WILLNEED;
+    madvise(reinterpret_cast<void *>(start), span, advice);  // advice only, failure is harmless
+}
+
+void prefetch(std::vector<const void *> &addresses) {
+    for (const void *&address : addresses) {
+        address = reinterpret_cast<const void *>(reinterpret_cast<std::uintptr_t>(address) / pageSize() * pageSize());
+    }
+    std::sort(addresses.begin(), addresses.end());
+    addresses.erase(std::unique(addresses.begin(), addresses.end()), addresses.end());
+
+    // one call per run of adjacent pages
+    for (auto first = addresses.begin(); first != addresses.end();) {
+        auto last = first + 1;
+        while (last != addresses.end() &&
+               static_cast<const char *>(*last) == static_cast<const char *>(*(last - 1)) + pageSize()) {
+            last++;
+        }
+        advise(*first, (last - first) * pageSize(), Access::WILLNEED);
+        first = last;
+    }
+}
+
+/*************************************
+ * Mapped Arena
+ *************************************/
+
+void *MappedArena::allocate(std::size_t bytes, std::size_t alignment) {
+    std::size_t offset = (used + alignment - 1) / alignment * alignment;
+    if (chunks.empty() || offset + bytes > chunks.back()->size()) {
+        chunks.push_back(MappedFile::create(directory, std::max(bytes, chunkSize)));
+        offset = 0;
+    }
+
+    used = offset + bytes;
+    return chunks.back()->data() + offset;
+}
+
+void MappedArena::advise(Access access) const {
+    for (const auto &chunk : chunks) {
+        ::advise(chunk->data(), chunk->size(), access);
+    }
+}
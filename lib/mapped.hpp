@@ -0,0 +1,112 @@
+#ifndef POTTSSAMPLER_MAPPED_H
+#define POTTSSAMPLER_MAPPED_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/// the page size used to align memory-mapped layouts
+std::size_t pageSize();
+
+/// round bytes up to a whole number of pages
+std::size_t pageAlign(std::size_t bytes);
+
+/// A file mapped into memory, unmapped on destruction.
+class MappedFile {
+   public:
+    /// map an existing file read-only
+    static std::shared_ptr<MappedFile> open(const std::string &path);
+
+    /// create and map a read-write file of (at least) size bytes in directory; the
+    /// file is unlinked immediately, so it is removed when the mapping is released
+    static std::shared_ptr<MappedFile> create(const std::string &directory, std::size_t size);
+
+    MappedFile(const MappedFile &)            = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    ~MappedFile();
+
+    char *data() const { return static_cast<char *>(address); }
+
+    std::size_t size() const { return length; }
+
+   private:
+    MappedFile(void *address, std::size_t length) : address(address), length(length) {}
+
+    void *address;
+    std::size_t length;
+};
+
+/// how a memory-mapped range is about to be accessed
+enum class Access { SEQUENTIAL, RANDOM, WILLNEED };
+
+/// advise the kernel of the access pattern of [data, data + size)
+void advise(const void *data, std::size_t size, Access access);
+
+/// ask the kernel to read in the pages holding each address, in page order, with one request per run of
+/// adjacent pages
+void prefetch(std::vector<const void *> &addresses);
+
+/// A bump allocator over memory-mapped files. Memory is only released when the
+/// arena is destroyed, so it suits containers which are sized once.
+class MappedArena {
+   public:
+    explicit MappedArena(std::string directory, std::size_t chunkSize = std::size_t{64} << 20)
+        : directory(std::move(directory)), chunkSize(chunkSize) {}
+
+    void *allocate(std::size_t bytes, std::size_t alignment);
+
+    /// advise the kernel of the access pattern of every mapping in the arena
+    void advise(Access access) const;
+
+   private:
+    std::string directory;
+    std::size_t chunkSize;
+
+    std::vector<std::shared_ptr<MappedFile>> chunks;
+    std::size_t used = 0;
+};
+
+/// Allocates from a MappedArena, or from the heap when no arena is given.
+/// Copies of a container are allocated on the heap, so only the containers
+/// constructed with the arena live in it; a container moved into another
+/// takes its allocator along, so that it stays in the arena.
+template<typename T>
+struct MappedAllocator {
+    using value_type                             = T;
+    using propagate_on_container_move_assignment = std::true_type;
+
+    MappedAllocator() = default;
+
+    explicit MappedAllocator(MappedArena *arena) : arena(arena) {}
+
+    template<typename U>
+    MappedAllocator(const MappedAllocator<U> &other) : arena(other.arena) {}
+
+    T *allocate(std::size_t n) {
+        return arena ? static_cast<T *>(arena->allocate(n * sizeof(T), alignof(T))) : std::allocator<T>{}.allocate(n);
+    }
+
+    void deallocate(T *p, std::size_t n) {
+        if (!arena) {
+            std::allocator<T>{}.deallocate(p, n);
+        }
+    }
+
+    MappedAllocator select_on_container_copy_construction() const { return {}; }
+
+    template<typename U>
+    bool operator==(const MappedAllocator<U> &other) const {
+        return arena == other.arena;
+    }
+
+    template<typename U>
+    bool operator!=(const MappedAllocator<U> &other) const {
+        return arena != other.arena;
+    }
+
+    MappedArena *arena = nullptr;
+};
+
+#endif  // POTTSSAMPLER_MAPPED_H
@@ -0,0 +1,150 @@
+#ifndef POTTSSAMPLER_MATHS_H
+#define POTTSSAMPLER_MATHS_H
+
+#include <cmath>
+#include <cstdint>
+
+#include "state.hpp"
+
+/// The arithmetic of the compress and contract updates, in one place for the
+/// update classes and the lockstep engine. A set of colours is a BoundingList,
+/// a ColourSet or a mask with one bit per colour (at most 64 colours); the
+/// scalar type T of the weights is long double for the update classes and
+/// double for the lockstep engine.
+namespace maths {
+
+inline bool contains(const BoundingList &set, int c) { return set[c]; }
+
+inline bool contains(std::uint64_t set, int c) { return set >> c & 1; }
+
+inline bool contains(const ColourSet &set, int c) { return set[c]; }
+
+inline void insert(BoundingList &set, int c) { set.set(c); }
+
+inline void insert(std::uint64_t &set, int c) { set |= std::uint64_t{1} << c; }
+
+inline void erase(BoundingList &set, int c) { set.reset(c); }
+
+inline void erase(std::uint64_t &set, int c) { set &= ~(std::uint64_t{1} << c); }
+
+/// call f(c) for each colour c of set in increasing order, until f returns true
+/// \return true if f returned true
+template<typename F>
+bool forEach(const BoundingList &set, F &&f) {
+    for (auto c = set.find_first(); c != BoundingList::npos; c = set.find_next(c)) {
+        if (f(static_cast<int>(c))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// \sa forEach(const BoundingList &, F &&)
+template<typename F>
+bool forEach(std::uint64_t set, F &&f) {
+    for (; set; set &= set - 1) {
+        if (f(__builtin_ctzll(set))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// \sa forEach(const BoundingList &, F &&)
+template<typename F>
+bool forEach(const ColourSet &set, F &&f) {
+    for (int c = 0; c < set.size(); c++) {
+        if (set[c] && f(c)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// keep the size smallest colours of A, then add the smallest colours missing from A until it has size colours
+/// \sa queries::getA
+template<typename Set>
+void fitA(Set &A, int maxColours, int size) {
+    int count = 0;
+    for (int c = 0; c < maxColours; c++) {
+        if (!contains(A, c)) {
+            continue;
+        }
+        if (count < size) {
+            count++;
+        } else {
+            erase(A, c);
+        }
+    }
+    for (int c = 0; count < size; c++) {
+        if (!contains(A, c)) {
+            insert(A, c);
+            count++;
+        }
+    }
+}
+
+/// set powers[k] = B^k for each k < powers.size()
+template<typename T, typename Powers>
+void powers(T temperature, Powers &powers) {
+    for (int k = 0; k < powers.size(); k++) {
+        powers[k] = std::pow(temperature, k);
+    }
+}
+
+/// \return the sum of weight(c) over the colours c < maxColours
+template<typename T, typename Weight>
+T norm(int maxColours, Weight &&weight) {
+    T result = 0;
+    for (int c = 0; c < maxColours; c++) {
+        result += weight(c);
+    }
+    return result;
+}
+
+/// the contract update keeps c1 as the colour of v when gamma < B^{m_{c1}} |U| / sum_c B^{m_c}, where U is the set
+/// of unfixed colours around v
+template<typename T>
+T contractCutoff(T weightOfC1, int unfixedCount, T norm) {
+    return weightOfC1 * unfixedCount / norm;
+}
+
+/// the contract update keeps c1 in the bounding list of v unless gamma > |U| / (q - Delta (1 - B))
+template<typename T>
+T boundingListCutoff(int unfixedCount, int maxColours, int maxDegree, T temperature) {
+    return unfixedCount / (maxColours - maxDegree * (1 - temperature));
+}
+
+/// the compress update keeps c1 as the colour of v when gamma < (q - Delta) B^{m_{c1}} / sum_c B^{m_c}, and
+/// otherwise samples from A, see sampleWeighted
+template<typename T>
+T compressCutoff(T weightOfC1, int maxColours, int maxDegree, T norm) {
+    return (maxColours - maxDegree) * weightOfC1 / norm;
+}
+
+/// sample a colour of set with probability proportional to weight(c), by the inverse transform of u in [0, 1]
+/// \return the colour, or -1 if rounding left every partial sum at or below u times the total weight
+template<typename T, typename Set, typename Weight>
+int sampleWeighted(const Set &set, Weight &&weight, T u) {
+    T total = 0;
+    forEach(set, [&](int c) {
+        total += weight(c);
+        return false;
+    });
+
+    const T target = u * total;
+    T partial      = 0;
+    int result     = -1;
+    forEach(set, [&](int c) {
+        if (partial + weight(c) > target) {
+            result = c;
+            return true;
+        }
+        partial += weight(c);
+        return false;
+    });
+    return result;
+}
+}  // namespace maths
+
+#endif  // POTTSSAMPLER_MATHS_H
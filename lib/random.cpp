@@ -1,16 +1,15 @@
 #include "random.hpp"
 
 /// a seed for random number generators
-std::mt19937 mersene_gen{std::random_device{}()};
+thread_local std::mt19937 mersene_gen{std::random_device{}()};
 
-std::uniform_real_distribution<double> uniformDist(0.0, 1.0);
-
-int uniformSample(const boost::dynamic_bitset<> &bs) {
-    std::vector<int> weights(bs.size(), 0);
-    for (int i = 0; i < bs.size(); i++) {
-        weights[i] = bs[i];
-    }
-    return sampleFromDist<int>(weights);
-}
+thread_local std::uniform_real_distribution<double> uniformDist(0.0, 1.0);
 
 long double unitSample() { return uniformDist(mersene_gen); }
+
+void seed(std::uint64_t seed, std::uint64_t stream) {
+    std::seed_seq sequence{static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32),
+                           static_cast<std::uint32_t>(stream), static_cast<std::uint32_t>(stream >> 32)};
+    mersene_gen.seed(sequence);
+    uniformDist.reset();
+}
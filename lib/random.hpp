@@ -1,10 +1,39 @@
 #ifndef POTTSSAMPLER_RANDOM_H
 #define POTTSSAMPLER_RANDOM_H
 
+#include <array>
 #include <boost/dynamic_bitset.hpp>
+#include <cstdint>
+#include <limits>
 #include <random>
 
-extern std::mt19937 mersene_gen;
+/// each thread samples from its own generator
+extern thread_local std::mt19937 mersene_gen;
+
+/// sample i with probability proportional to weight(i), for i in 0, ..., size - 1
+/// the inverse transform of std::discrete_distribution, walking the cumulative weights rather than storing them,
+/// so that sampling does not allocate; returns 0 when size < 2 or every weight is zero
+template<typename Weight>
+int sampleFromDist(int size, Weight &&weight) {
+    if (size < 2) {
+        return 0;
+    }
+
+    double norm = 0;
+    for (int i = 0; i < size; i++) {
+        norm += static_cast<double>(weight(i));
+    }
+
+    const double target = std::generate_canonical<double, std::numeric_limits<double>::digits>(mersene_gen);
+    double total        = 0;
+    for (int i = 0; i + 1 < size; i++) {
+        total += static_cast<double>(weight(i)) / norm;
+        if (!(total < target)) {
+            return i;
+        }
+    }
+    return size - 1;
+}
 
 /// template for sampling from the distribution described by weights
 /// \tparam weight_type the type of the elements of weights
@@ -13,14 +42,32 @@ extern std::mt19937 mersene_gen;
 /// described by weights
 template<typename weight_type>
 int sampleFromDist(const std::vector<weight_type> &weights) {
-    std::discrete_distribution<int> dist(weights.begin(), weights.end());
-    return dist(mersene_gen);
+    return sampleFromDist(static_cast<int>(weights.size()), [&weights](int i) { return weights[i]; });
+}
+
+/// \sa sampleFromDist
+template<typename weight_type, std::size_t N>
+int sampleFromDist(const std::array<weight_type, N> &weights) {
+    return sampleFromDist(static_cast<int>(N), [&weights](int i) { return weights[i]; });
 }
 
 /// select random set bit
-int uniformSample(const boost::dynamic_bitset<> &bs);
+template<typename Block, typename Allocator>
+int uniformSample(const boost::dynamic_bitset<Block, Allocator> &bs) {
+    return sampleFromDist(static_cast<int>(bs.size()), [&bs](int i) { return static_cast<int>(bs[i]); });
+}
+
+/// select random unset bit, without the copy made by flipping bs
+template<typename Block, typename Allocator>
+int uniformSampleUnset(const boost::dynamic_bitset<Block, Allocator> &bs) {
+    return sampleFromDist(static_cast<int>(bs.size()), [&bs](int i) { return static_cast<int>(!bs[i]); });
+}
 
 /// sample from the uniform distribution over the interval [0, 1]
 long double unitSample();
 
+/// reseed the generator of the calling thread; distinct streams under the same seed give
+/// independent sequences, so work split across threads can be made reproducible
+void seed(std::uint64_t seed, std::uint64_t stream);
+
 #endif  // POTTSSAMPLER_RANDOM_H
@@ -1,54 +1,313 @@
 #include "sampler.hpp"
 
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <numeric>
+#include <random>
+#include <set>
+
+#include "glauber.hpp"
+#include "lockstep.hpp"
+#include "mapped.hpp"
+#include "trace.hpp"
 #include "update.hpp"
 
 /*************************************
  * Parameters
  *************************************/
 
-bool Parameters::verify(const Graph& graph) const {
-    bool failed = false;
+std::vector<std::string> Parameters::violations(const Graph& graph) const {
+    std::vector<std::string> result;
 
     if (graph.getMaxDegree() < 3) {
-        std::cout << "Delta must be greater than 2." << std::endl;
-        failed |= true;
+        result.emplace_back("Delta must be greater than 2.");
     }
 
     if (maxColours <= 2 * graph.getMaxDegree()) {
-        std::cout << "The number of colours q must be greater than 2 * Delta. Delta is " << graph.getMaxDegree() << '.' << std::endl;
-        failed |= true;
+        result.emplace_back("The number of colours q must be greater than 2 * Delta. Delta is " +
+                            std::to_string(graph.getMaxDegree()) + '.');
     }
 
     if (temperature >= 1) {
-        std::cout << "B must be less than 1." << std::endl;
-        failed |= true;
+        result.emplace_back("B must be less than 1.");
     }
 
     if (const long double min_B = 1 - static_cast<long double>(maxColours - 2 * graph.getMaxDegree()) / graph.getMaxDegree();
         temperature <= min_B) {
-        std::cout << "B, Delta and q must satisfy B > 1 - (q - 2 * Delta) / Delta, i.e. B > " << std::to_string(min_B)
-                  << std::endl;
-        failed |= true;
+        result.emplace_back("B, Delta and q must satisfy B > 1 - (q - 2 * Delta) / Delta, i.e. B > " +
+                            std::to_string(min_B));
     }
 
-    return !failed;
+    return result;
+}
+
+bool Parameters::verify(const Graph& graph) const {
+    const std::vector<std::string> failed = violations(graph);
+    for (const std::string& message : failed) {
+        std::cout << message << std::endl;
+    }
+    return failed.empty();
 }
 
 /*************************************
  * Graph
  *************************************/
 
-Graph::Graph(int numNodes, const std::vector<edge_t> &edges)
-        : adjacencyMatrix{std::vector<std::vector<int>>(numNodes, std::vector<int>())}
-{
+namespace {
+/// the heap-allocated arrays of a graph
+struct Arrays {
+    std::vector<std::int64_t> offsets;
+    std::vector<int> targets;
+    std::vector<int> labels;
+};
+
+/// the header of a graph file; each array starts on a page boundary at the given byte offset
+struct GraphHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t hasLabels;
+    std::int64_t numNodes;
+    std::int64_t numTargets;
+    std::int64_t maxDegree;
+    std::int64_t offsetsAt;
+    std::int64_t targetsAt;
+    std::int64_t labelsAt;
+};
+
+constexpr char graphMagic[8]       = "POTTSGR";
+constexpr std::uint32_t graphVersion = 1;
+}  // namespace
+
+Graph::Graph(int numNodes, const std::vector<edge_t> &edges, Ordering ordering) : numNodes(numNodes) {
+    auto arrays = std::make_shared<Arrays>();
+
+    // count the degrees, then place each edge in the rows of both endpoints
+    arrays->offsets.assign(numNodes + 1, 0);
     for (const edge_t &edge : edges) {
-        adjacencyMatrix[edge.first].emplace_back(edge.second);
-        adjacencyMatrix[edge.second].emplace_back(edge.first);
+        ++arrays->offsets[edge.first + 1];
+        ++arrays->offsets[edge.second + 1];
+    }
+    std::partial_sum(arrays->offsets.begin(), arrays->offsets.end(), arrays->offsets.begin());
+
+    arrays->targets.resize(arrays->offsets[numNodes]);
+    std::vector<std::int64_t> next(arrays->offsets.begin(), arrays->offsets.end() - 1);
+    for (const edge_t &edge : edges) {
+        arrays->targets[next[edge.first]++]  = edge.second;
+        arrays->targets[next[edge.second]++] = edge.first;
+    }
+
+    offsets = arrays->offsets.data();
+    targets = arrays->targets.data();
+    storage = arrays;
+
+    for (int node{}; node < numNodes; ++node) {
+        maxDegree = std::max(maxDegree, getNeighbours(node).size());
+    }
+
+    if (ordering == Ordering::NONE) {
+        return;
+    }
+
+    // relabel so that vertex i is the ith vertex of the ordering
+    auto relabelled    = std::make_shared<Arrays>();
+    relabelled->labels = order(ordering);
+    std::vector<int> internal(numNodes);
+    for (int v = 0; v < numNodes; v++) {
+        internal[relabelled->labels[v]] = v;
+    }
+
+    relabelled->offsets.assign(numNodes + 1, 0);
+    relabelled->targets.reserve(arrays->targets.size());
+    for (int v = 0; v < numNodes; v++) {
+        for (int neighbour : getNeighbours(relabelled->labels[v])) {
+            relabelled->targets.emplace_back(internal[neighbour]);
+        }
+        relabelled->offsets[v + 1] = relabelled->targets.size();
+        std::sort(relabelled->targets.begin() + relabelled->offsets[v], relabelled->targets.end());
+    }
+
+    offsets = relabelled->offsets.data();
+    targets = relabelled->targets.data();
+    labels  = relabelled->labels.data();
+    storage = relabelled;
+}
+
+Graph Graph::random(int numNodes, int maxDegree, unsigned seed, Ordering ordering) {
+    std::mt19937 gen{seed};
+
+    // pair up maxDegree stubs per vertex, dropping loops and repeated edges
+    std::vector<int> stubs;
+    for (int v = 0; v < numNodes; v++) {
+        stubs.insert(stubs.end(), maxDegree, v);
     }
+    std::shuffle(stubs.begin(), stubs.end(), gen);
 
-    for (int node{}; node < adjacencyMatrix.size(); ++node) {
-        maxDegree = std::max(maxDegree, static_cast<int>(adjacencyMatrix[node].size()));
+    std::set<edge_t> edges;
+    for (int i = 0; i + 1 < stubs.size(); i += 2) {
+        if (stubs[i] != stubs[i + 1]) {
+            edges.emplace(std::minmax(stubs[i], stubs[i + 1]));
+        }
     }
+
+    return {numNodes, std::vector<edge_t>(edges.begin(), edges.end()), ordering};
+}
+
+std::vector<int> Graph::order(Ordering ordering) const {
+    std::vector<int> vertices(size());
+    std::iota(vertices.begin(), vertices.end(), 0);
+
+    auto byDegree = [this](int v, int w) { return getNeighbours(v).size() < getNeighbours(w).size(); };
+
+    switch (ordering) {
+        case Ordering::NONE:
+            return vertices;
+
+        case Ordering::DEGREE:
+            std::stable_sort(vertices.begin(), vertices.end(), byDegree);
+            return vertices;
+
+        case Ordering::BFS:
+        case Ordering::REVERSE_CUTHILL_MCKEE: {
+            // start each component from a vertex of minimum degree
+            std::stable_sort(vertices.begin(), vertices.end(), byDegree);
+
+            std::vector<int> result;
+            std::vector<bool> visited(size());
+            std::vector<int> neighbours;
+            for (int root : vertices) {
+                if (visited[root]) {
+                    continue;
+                }
+
+                visited[root] = true;
+                result.push_back(root);
+                for (auto head = result.size() - 1; head < result.size(); head++) {
+                    Neighbours row = getNeighbours(result[head]);
+                    neighbours.assign(row.begin(), row.end());
+                    if (ordering == Ordering::REVERSE_CUTHILL_MCKEE) {
+                        std::stable_sort(neighbours.begin(), neighbours.end(), byDegree);
+                    }
+                    for (int neighbour : neighbours) {
+                        if (!visited[neighbour]) {
+                            visited[neighbour] = true;
+                            result.push_back(neighbour);
+                        }
+                    }
+                }
+            }
+
+            if (ordering == Ordering::REVERSE_CUTHILL_MCKEE) {
+                std::reverse(result.begin(), result.end());
+            }
+            return result;
+        }
+
+        default:
+            throw std::invalid_argument("Invalid vertex ordering.");
+    }
+}
+
+void Graph::save(const std::string &path) const {
+    GraphHeader header{};
+    std::copy(std::begin(graphMagic), std::end(graphMagic), header.magic);
+    header.version    = graphVersion;
+    header.hasLabels  = labels != nullptr;
+    header.numNodes   = numNodes;
+    header.numTargets = offsets[numNodes];
+    header.maxDegree  = maxDegree;
+    header.offsetsAt  = pageAlign(sizeof(GraphHeader));
+    header.targetsAt  = header.offsetsAt + pageAlign((numNodes + 1) * sizeof(std::int64_t));
+    header.labelsAt   = header.targetsAt + pageAlign(header.numTargets * sizeof(int));
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    auto writeAt = [&out](std::int64_t position, const void *data, std::size_t bytes) {
+        // zero-fill up to the start of the section
+        std::vector<char> padding(position - out.tellp(), 0);
+        out.write(padding.data(), padding.size());
+        out.write(static_cast<const char *>(data), bytes);
+    };
+
+    writeAt(0, &header, sizeof(header));
+    writeAt(header.offsetsAt, offsets, (numNodes + 1) * sizeof(std::int64_t));
+    writeAt(header.targetsAt, targets, header.numTargets * sizeof(int));
+    if (labels) {
+        writeAt(header.labelsAt, labels, numNodes * sizeof(int));
+    }
+
+    if (!out) {
+        throw std::runtime_error("Could not write the graph to " + path);
+    }
+}
+
+Graph Graph::map(const std::string &path) {
+    auto file = MappedFile::open(path);
+
+    GraphHeader header{};
+    if (file->size() < sizeof(header)) {
+        throw std::runtime_error(path + " is not a graph file.");
+    }
+    std::memcpy(&header, file->data(), sizeof(header));
+
+    const std::size_t end =
+        header.hasLabels ? header.labelsAt + header.numNodes * sizeof(int) : header.targetsAt + header.numTargets * sizeof(int);
+    if (!std::equal(std::begin(graphMagic), std::end(graphMagic), header.magic) || header.version != graphVersion ||
+        file->size() < end) {
+        throw std::runtime_error(path + " is not a graph file (or has an unsupported version).");
+    }
+
+    Graph graph;
+    graph.numNodes  = header.numNodes;
+    graph.maxDegree = header.maxDegree;
+    graph.offsets   = reinterpret_cast<const std::int64_t *>(file->data() + header.offsetsAt);
+    graph.targets   = reinterpret_cast<const int *>(file->data() + header.targetsAt);
+    graph.labels    = header.hasLabels ? reinterpret_cast<const int *>(file->data() + header.labelsAt) : nullptr;
+    graph.storage   = file;
+    return graph;
+}
+
+Graph Graph::view(int numNodes, const std::int64_t *offsets, const int *targets) {
+    if (numNodes < 0 || !offsets || (numNodes > 0 && !targets) || offsets[0] != 0) {
+        throw std::invalid_argument("Invalid compressed sparse rows.");
+    }
+
+    Graph graph;
+    graph.numNodes = numNodes;
+    graph.offsets  = offsets;
+    graph.targets  = targets;
+    for (int v = 0; v < numNodes; v++) {
+        if (offsets[v + 1] < offsets[v]) {
+            throw std::invalid_argument("The offsets of a graph must be non-decreasing.");
+        }
+        for (int w : graph.getNeighbours(v)) {
+            if (w < 0 || w >= numNodes || w == v) {
+                throw std::invalid_argument("Vertex " + std::to_string(v) + " has an invalid neighbour " +
+                                            std::to_string(w) + '.');
+            }
+        }
+        graph.maxDegree = std::max(graph.maxDegree, graph.getNeighbours(v).size());
+    }
+    return graph;
+}
+
+Graph Graph::replicate() const {
+    auto arrays = std::make_shared<Arrays>();
+    arrays->offsets.assign(offsets, offsets + numNodes + 1);
+    arrays->targets.assign(targets, targets + offsets[numNodes]);
+    if (labels) {
+        arrays->labels.assign(labels, labels + numNodes);
+    }
+
+    Graph graph;
+    graph.numNodes  = numNodes;
+    graph.maxDegree = maxDegree;
+    graph.offsets   = arrays->offsets.data();
+    graph.targets   = arrays->targets.data();
+    graph.labels    = labels ? arrays->labels.data() : nullptr;
+    graph.storage   = arrays;
+    return graph;
 }
 
 /// helper function for constructing a set of edges
@@ -83,12 +342,6 @@ std::vector<Graph::edge_t> Graph::buildEdgeSet(int n, Graph::Type type) {
     }
 }
 
-int Graph::numEdges() const {
-    return std::accumulate(adjacencyMatrix.begin(), adjacencyMatrix.end(), 0,
-                           [](int acc, const auto &neighbours) { return acc + neighbours.size(); }) /
-           2;
-}
-
 std::ostream &operator<<(std::ostream &out, const Graph &graph) {
     for (int v = 0; v < graph.size(); v++) {
         out << v << ": {";
@@ -112,120 +365,609 @@ std::istream& operator>>(std::istream& is, Graph::Type& type) {
     return is;
 }
 
+std::istream& operator>>(std::istream& is, Graph::Ordering& ordering) {
+    std::string token;
+    is >> token;
+    if (token == "none") {
+        ordering = Graph::Ordering::NONE;
+    } else if (token == "bfs") {
+        ordering = Graph::Ordering::BFS;
+    } else if (token == "rcm") {
+        ordering = Graph::Ordering::REVERSE_CUTHILL_MCKEE;
+    } else if (token == "degree") {
+        ordering = Graph::Ordering::DEGREE;
+    } else {
+        is.setstate(std::ios_base::failbit);
+    }
+    return is;
+}
+
+std::istream& operator>>(std::istream& is, SamplingOptions::Engine& engine) {
+    std::string token;
+    is >> token;
+    if (token == "perfect") {
+        engine = SamplingOptions::Engine::PERFECT;
+    } else if (token == "glauber") {
+        engine = SamplingOptions::Engine::GLAUBER;
+    } else if (token == "lockstep") {
+        engine = SamplingOptions::Engine::LOCKSTEP;
+    } else {
+        is.setstate(std::ios_base::failbit);
+    }
+    return is;
+}
+
+std::istream& operator>>(std::istream& is, SamplingOptions::History& history) {
+    std::string token;
+    is >> token;
+    if (token == "full") {
+        history = SamplingOptions::History::FULL;
+    } else if (token == "regenerated") {
+        history = SamplingOptions::History::REGENERATED;
+    } else {
+        is.setstate(std::ios_base::failbit);
+    }
+    return is;
+}
 
 /*************************************
  * Main Sampling Algorithm
  *************************************/
 
+/// every update of an epoch, kept for the replay
+/// epoch() keeps the set A of each vertex through keep, constructs its updates through compress and contract,
+/// and calls endPhaseOne between the phases; Discard and Replay below are the other histories it runs with
+template<typename Kernel>
 struct Epoch {
-    std::vector<CompressUpdate> phaseOneHistory{};
-    std::vector<ContractUpdate> phaseTwoHistory{};
+    std::vector<CompressUpdate<Kernel>> phaseOneHistory{};
+    std::vector<ContractUpdate<Kernel>> phaseTwoHistory{};
+
+    // the sets A of the compress updates, one per free vertex, reserved with the epoch
+    ColourSets sets{};
+
+    /// make room for the updates and sets of an epoch on state, so that none is reallocated
+    void reserve(const typename Kernel::state_t &state, std::int64_t phaseTwoIters) {
+        phaseOneHistory.reserve(state.graph.numEdges());
+        // phase two makes one update per iteration (none if phaseTwoIters is negative), plus the contract
+        // updates of phase one
+        phaseTwoHistory.reserve(state.freeVertices.size() + std::max<std::int64_t>(phaseTwoIters, 0));
+        sets.reserve(Kernel::maxColours(state), state.freeVertices.size());
+    }
+
+    ColourSet keep(const BoundingList &A) { return sets.add(A); }
+
+    template<typename... Args>
+    const CompressUpdate<Kernel> &compress(Args &&...args) {
+        return phaseOneHistory.emplace_back(std::forward<Args>(args)...);
+    }
+
+    template<typename... Args>
+    const ContractUpdate<Kernel> &contract(Args &&...args) {
+        return phaseTwoHistory.emplace_back(std::forward<Args>(args)...);
+    }
+
+    void endPhaseOne() {}
+};
+
+/// the start of an epoch, from which its updates are generated again during the replay
+struct Snapshot {
+    std::mt19937 generator;
+
+    // bit v * q + c is set if c is in the bounding list of v
+    boost::dynamic_bitset<> boundingChain;
 };
 
-static int getPhaseTwoIters(const Graph &graph, const Parameters &parameters);
+/// keeps only the update being applied, for forward epochs whose updates are regenerated from a Snapshot
+template<typename Kernel>
+class Discard {
+   public:
+    explicit Discard(const typename Kernel::state_t &state) { sets.reserve(Kernel::maxColours(state), 1); }
 
-void update(State &state, const ContractUpdate &update);
-void update(State &state, const CompressUpdate &update);
+    ColourSet keep(const BoundingList &A) {
+        sets.clear();
+        return sets.add(A);
+    }
 
-void updateColouring(State &state, const ContractUpdate &update);
-void updateColouring(State &state, const CompressUpdate &update);
+    template<typename... Args>
+    const CompressUpdate<Kernel> &compress(Args &&...args) {
+        return compressUpdate.emplace(std::forward<Args>(args)...);
+    }
 
-void updateColourWithEpoch(State &model, Epoch &epoch);
+    template<typename... Args>
+    const ContractUpdate<Kernel> &contract(Args &&...args) {
+        return contractUpdate.emplace(std::forward<Args>(args)...);
+    }
+
+    void endPhaseOne() {}
+
+   private:
+    ColourSets sets;
+    std::optional<CompressUpdate<Kernel>> compressUpdate;
+    std::optional<ContractUpdate<Kernel>> contractUpdate;
+};
 
-Epoch epoch(State &model, int phaseTwoIters);
+template<typename Kernel>
+void update(typename Kernel::state_t &state, const ContractUpdate<Kernel> &update);
+template<typename Kernel>
+void update(typename Kernel::state_t &state, const CompressUpdate<Kernel> &update);
 
-void sample(State &state);
+template<typename Kernel>
+void updateColouring(typename Kernel::state_t &state, const ContractUpdate<Kernel> &update);
+template<typename Kernel>
+void updateColouring(typename Kernel::state_t &state, const CompressUpdate<Kernel> &update);
 
+template<typename Kernel>
+void updateColourWithEpoch(typename Kernel::state_t &model, Epoch<Kernel> &epoch);
 
-std::optional<std::vector<int>> sample(const Parameters &parameters, const Graph &graph) {
+/// evaluates the colours of a regenerated epoch in the order of updateColourWithEpoch: the updates of phase
+/// one are kept until it ends, then those of phase two are evaluated as they are generated
+template<typename Kernel>
+class Replay {
+   public:
+    // the updates of phase two are not kept
+    explicit Replay(typename Kernel::state_t &state) : state(state) { phaseOne.reserve(state, 0); }
+
+    ColourSet keep(const BoundingList &A) { return phaseOne.keep(A); }
+
+    template<typename... Args>
+    const CompressUpdate<Kernel> &compress(Args &&...args) {
+        return phaseOne.compress(std::forward<Args>(args)...);
+    }
+
+    template<typename... Args>
+    const ContractUpdate<Kernel> &contract(Args &&...args) {
+        if (!phaseTwo) {
+            return phaseOne.contract(std::forward<Args>(args)...);
+        }
+
+        const ContractUpdate<Kernel> &update = contractUpdate.emplace(std::forward<Args>(args)...);
+        updateColouring(state, update);
+        return update;
+    }
+
+    void endPhaseOne() {
+        updateColourWithEpoch(state, phaseOne);
+        phaseTwo = true;
+    }
+
+   private:
+    typename Kernel::state_t &state;
+    Epoch<Kernel> phaseOne;
+    bool phaseTwo = false;
+    std::optional<ContractUpdate<Kernel>> contractUpdate;
+};
+
+template<typename Kernel, typename History>
+void epoch(typename Kernel::state_t &model, std::int64_t phaseTwoIters, History &history);
+
+template<typename Kernel>
+int sample(typename Kernel::state_t &state, SamplingOptions::History mode);
+
+
+/// \param epochs if not null, set to the number of epochs run
+/// \param colouring the graph.size() colours to write the sample to
+template<typename Colour>
+static void samplePerfect(const Parameters &parameters, const Graph &graph, Colour *colouring,
+                          const SamplingOptions &options = {}, int *epochs = nullptr);
+
+/// \throw std::invalid_argument if Colour cannot hold every colour
+template<typename Colour>
+static void checkColourType(const Parameters &parameters) {
+    if (!kernels::fits<Colour>(parameters.maxColours)) {
+        throw std::invalid_argument("The colour type is too narrow for " + std::to_string(parameters.maxColours) +
+                                    " colours.");
+    }
+}
+
+/// \throw std::invalid_argument if options.pinned is set for an engine other than the perfect one, or
+/// does not give a colour or -1 for every vertex
+static void checkPinned(const Parameters &parameters, const Graph &graph, const SamplingOptions &options) {
+    if (options.pinned.empty()) {
+        return;
+    }
+    if (options.engine != SamplingOptions::Engine::PERFECT) {
+        throw std::invalid_argument("Pinned vertices are only supported by the perfect engine.");
+    }
+    if (options.pinned.size() != graph.size()) {
+        throw std::invalid_argument("Pinned colours must be given for each of the " + std::to_string(graph.size()) +
+                                    " vertices.");
+    }
+    for (int colour : options.pinned) {
+        if (colour < -1 || colour >= parameters.maxColours) {
+            throw std::invalid_argument("Invalid pinned colour " + std::to_string(colour) + '.');
+        }
+    }
+}
+
+/// \throw std::invalid_argument if options asks the lockstep engine for the regenerated history or memory-mapped
+/// storage, which only the perfect engine supports
+static void checkLockstep(const SamplingOptions &options) {
+    if (options.engine != SamplingOptions::Engine::LOCKSTEP) {
+        return;
+    }
+    if (options.history != SamplingOptions::History::FULL) {
+        throw std::invalid_argument("The regenerated history is only supported by the perfect engine.");
+    }
+    if (!options.storageDirectory.empty()) {
+        throw std::invalid_argument("Memory-mapped storage is only supported by the perfect engine.");
+    }
+}
+
+template<typename Colour>
+std::optional<basic_colouring_t<Colour>> sample(const Parameters &parameters, const Graph &graph) {
+    checkColourType<Colour>(parameters);
     if (!parameters.verify(graph)) {
         return std::nullopt;
     }
 
-    BoundingList defaultBL(parameters.maxColours);
-    defaultBL.set();
+    basic_colouring_t<Colour> colouring(graph.size());
+    samplePerfect(parameters, graph, colouring.data());
+    return colouring;
+}
+
+template<typename Colour>
+bool sample(const Parameters &parameters, const Graph &graph, Colour *colouring) {
+    checkColourType<Colour>(parameters);
+    if (!parameters.verify(graph)) {
+        return false;
+    }
+
+    samplePerfect(parameters, graph, colouring);
+    return true;
+}
+
+template<typename Colour>
+std::optional<BasicSamples<Colour>> sample(const Parameters &parameters, const Graph &graph, int numSamples,
+                                           const SamplingOptions &options) {
+    checkColourType<Colour>(parameters);
+    checkPinned(parameters, graph, options);
+    checkLockstep(options);
+    BasicSamples<Colour> samples;
+
+    if (options.engine == SamplingOptions::Engine::PERFECT) {
+        if (!parameters.verify(graph)) {
+            return std::nullopt;
+        }
+
+        for (int i = 0; i < numSamples; i++) {
+            int epochs;
+            samplePerfect(parameters, graph, samples.colourings.emplace_back(graph.size()).data(), options, &epochs);
+            samples.epochs.emplace_back(epochs);
+        }
+        return samples;
+    }
+
+    if (options.engine == SamplingOptions::Engine::LOCKSTEP) {
+        if (!parameters.verify(graph)) {
+            return std::nullopt;
+        }
+
+        lockstep::run(parameters, graph, numSamples, samples);
+        return samples;
+    }
+
+    // split the samples between the chains, each running on its own thread
+    const int numChains = std::max(1, std::min(options.chains, numSamples));
+    std::vector<std::future<glauber::BasicChain<Colour>>> futures;
+    for (int j = 0; j < numChains; j++) {
+        const int chainSamples = numSamples / numChains + (j < numSamples % numChains);
+        futures.emplace_back(std::async(std::launch::async, glauber::run<Colour>, std::cref(parameters),
+                                        std::cref(graph), chainSamples, std::cref(options)));
+    }
+
+    std::vector<std::vector<double>> energies;
+    double autocorrelationTime = 0;
+    for (auto &future : futures) {
+        glauber::BasicChain<Colour> chain = future.get();
+        std::move(chain.colourings.begin(), chain.colourings.end(), std::back_inserter(samples.colourings));
+        autocorrelationTime += glauber::autocorrelationTime(chain.energies);
+        energies.emplace_back(std::move(chain.energies));
+    }
+
+    samples.diagnostics = Diagnostics{.autocorrelationTime = autocorrelationTime / numChains,
+                                      .rHat                = glauber::gelmanRubin(energies)};
+    return samples;
+}
+
+#define POTTS_COLOUR(Colour)                                                                                      \
+    template std::optional<basic_colouring_t<Colour>> sample<Colour>(const Parameters &, const Graph &);          \
+    template bool sample<Colour>(const Parameters &, const Graph &, Colour *);                                    \
+    template std::optional<BasicSamples<Colour>> sample<Colour>(const Parameters &, const Graph &, int numSamples, \
+                                                                const SamplingOptions &);
+POTTS_COLOUR(std::uint8_t)
+POTTS_COLOUR(std::uint16_t)
+POTTS_COLOUR(int)
+#undef POTTS_COLOUR
+
+template<typename Colour>
+static void samplePerfect(const Parameters &parameters, const Graph &graph, Colour *colouring,
+                          const SamplingOptions &options, int *epochs) {
+    // out-of-core, the colouring and bounding chain are laid out in vertex order in memory-mapped files
+    std::unique_ptr<MappedArena> arena;
+    if (!options.storageDirectory.empty()) {
+        arena = std::make_unique<MappedArena>(options.storageDirectory);
+    }
+    MappedAllocator<unsigned long> allocator(arena.get());
+
+    // the kernel fixes the width of the colours held in the state
+    kernels::dispatch(parameters, graph, [&](auto kernel) {
+        using Kernel   = decltype(kernel);
+        using colour_t = typename Kernel::colour_t;
+
+        typename Kernel::state_t state{
+            .parameters    = parameters,
+            .graph         = graph,
+            .colouring     = BasicStateColouring<colour_t>(parameters.numNodes, 0, allocator),
+            .boundingChain = boundingchain_t(allocator)};
+        state.boundingChain.reserve(parameters.numNodes);
+        for (int v = 0; v < parameters.numNodes; v++) {
+            state.boundingChain.emplace_back(parameters.maxColours, allocator).set();
+        }
+
+        // pinned vertices start with their colour and a singleton bounding list, and are never updated
+        if (!options.pinned.empty()) {
+            state.pinned.resize(parameters.numNodes);
+            for (int v = 0; v < parameters.numNodes; v++) {
+                if (const int colour = options.pinned[graph.toOriginal(v)]; colour >= 0) {
+                    state.pinned[v]       = true;
+                    state.colouring[v]    = colour;
+                    state.boundingChain[v].reset().set(colour);
+                }
+            }
+        }
+        for (int v = 0; v < parameters.numNodes; v++) {
+            if (state.isFree(v)) {
+                state.freeVertices.push_back(v);
+            }
+        }
+        state.neighbourCounts = NeighbourCounts(graph, parameters.maxColours, state.boundingChain, allocator);
+
+        int t = sample<Kernel>(state, options.history);
+        if (epochs) {
+            *epochs = t;
+        }
+        graph.toOriginal(state.colouring, colouring);
+    });
+}
 
-    State state{.parameters    = parameters,
-                .graph         = graph,
-                .colouring     = colouring_t(parameters.numNodes),
-                .boundingChain = boundingchain_t(parameters.numNodes, defaultBL)};
-    sample(state);
-    return {state.colouring};
+/// the number of vertices whose bounding list is not a singleton, recorded with trace spans
+static long long nonSingletons(const boundingchain_t &boundingChain) {
+    return std::count_if(boundingChain.begin(), boundingChain.end(),
+                         [](const BoundingList &boundingList) { return boundingList.count() != 1; });
 }
 
-void sample(State &state) {
-    int phaseTwoIters = getPhaseTwoIters(state.graph, state.parameters);
-    std::vector<Epoch> history;
+template<typename State>
+static Snapshot snapshot(const State &state) {
+    const int q = state.parameters.maxColours;
+    Snapshot result{mersene_gen, boost::dynamic_bitset<>(state.graph.size() * q)};
+    for (int v = 0; v < state.graph.size(); v++) {
+        const BoundingList &boundingList = state.boundingChain[v];
+        for (auto c = boundingList.find_first(); c != BoundingList::npos; c = boundingList.find_next(c)) {
+            result.boundingChain.set(v * q + c);
+        }
+    }
+    return result;
+}
+
+/// return the generator and bounding chain to where they were when the snapshot was taken
+template<typename State>
+static void restore(State &state, const Snapshot &snapshot) {
+    const int q = state.parameters.maxColours;
+    for (int v = 0; v < state.graph.size(); v++) {
+        for (int c = 0; c < q; c++) {
+            state.boundingChain[v][c] = snapshot.boundingChain[v * q + c];
+        }
+    }
+    // in place, so that the counts stay where samplePerfect allocated them
+    state.neighbourCounts.recount(state.graph, state.boundingChain);
+    mersene_gen           = snapshot.generator;
+}
+
+/// \param mode how the updates of each epoch are kept for the replay, see SamplingOptions::History
+/// \return the number of epochs until the bounding chain coalesced
+template<typename Kernel>
+int sample(typename Kernel::state_t &state, SamplingOptions::History mode) {
+    trace::Span span("sample");
+    std::int64_t phaseTwoIters = state.pinned.empty()
+                                     ? getPhaseTwoIters(state.graph, state.parameters)
+                                     : getPhaseTwoIters(state.graph, state.parameters, state.freeVertices);
+    std::vector<Epoch<Kernel>> history;
+    std::vector<Snapshot> snapshots;
 
     // iterate until boundingChainIsConstant holds
     int t;
     for (t = 0; !queries::boundingChainIsConstant(state.boundingChain); t++) {
-        history.emplace_back(epoch(state, phaseTwoIters));
+        trace::Span epochSpan("epoch");
+        if (mode == SamplingOptions::History::FULL) {
+            Epoch<Kernel> &current = history.emplace_back();
+            current.reserve(state, phaseTwoIters);
+            epoch<Kernel>(state, phaseTwoIters, current);
+        } else {
+            snapshots.emplace_back(snapshot(state));
+            Discard<Kernel> discard(state);
+            epoch<Kernel>(state, phaseTwoIters, discard);
+        }
+        if (epochSpan) {
+            epochSpan.set("epoch", t);
+            epochSpan.set("nonSingleton", nonSingletons(state.boundingChain));
+        }
+    }
+
+    // the forward pass only evolves the bounding chain; every update keeps the colour of v in its
+    // bounding list, so the coalesced chain holds the colouring the updates would have produced
+    for (int v = 0; v < state.graph.size(); v++) {
+        state.colouring[v] = state.boundingChain[v].find_first();
     }
 
     // apply history (reversed)
-    t = 0;
-    for (auto it = ++history.rbegin(); it != history.rend(); it++, t++) {
-        updateColourWithEpoch(state, *it);
+    {
+        trace::Span replaySpan("replay");
+        replaySpan.set("epochs", t);
+        // no epoch runs when every vertex is pinned
+        for (auto it = history.empty() ? history.rend() : ++history.rbegin(); it != history.rend(); it++) {
+            updateColourWithEpoch(state, *it);
+        }
+
+        // the generated updates only touch the bounding chain, which is no longer needed; the generator is
+        // returned to the end of the forward pass, so that later samples draw fresh randomness
+        if (snapshots.size() > 1) {
+            const std::mt19937 generator = mersene_gen;
+            for (int e = static_cast<int>(snapshots.size()) - 2; e >= 0; e--) {
+                restore(state, snapshots[e]);
+                Replay<Kernel> replay(state);
+                epoch<Kernel>(state, phaseTwoIters, replay);
+            }
+            mersene_gen = generator;
+        }
     }
+
+    span.set("epochs", t);
+    return t;
+}
+
+/// ask the kernel to read in the pages which the phase two updates of the vertices in [first, last) will touch
+template<typename State>
+static void prefetchPhaseTwo(const State &state, const int *first, const int *last) {
+    std::vector<const void *> addresses;
+    for (const int *v = first; v != last; v++) {
+        addresses.push_back(state.graph.getNeighbours(*v).begin());
+        // the forward pass reads and writes only the bounding chain
+        for (int w : state.graph.getNeighbours(*v)) {
+            addresses.push_back(&state.boundingChain[w]);
+        }
+        addresses.push_back(&state.boundingChain[*v]);
+
+        // an update reads the counts of v, and writes those of its neighbours when the bounding list changes
+        state.neighbourCounts.addresses(*v, addresses);
+        for (int w : state.graph.getNeighbours(*v)) {
+            state.neighbourCounts.addresses(w, addresses);
+        }
+    }
+    prefetch(addresses);
 }
 
 /// run a single epoch of the algorithm
-Epoch epoch(State &state, int phaseTwoIters) {
-    Epoch epoch;
+/// \param history constructs the updates and keeps whatever the replay will need of them, see Epoch
+template<typename Kernel, typename History>
+void epoch(typename Kernel::state_t &state, std::int64_t phaseTwoIters, History &history) {
+    const MappedArena *arena = state.colouring.get_allocator().arena;
 
     // Phase One
-    BoundingList A(state.parameters.maxColours);
-    for (int v = 0; v < state.graph.size(); v++) {
-        // set A for the neighbourhood of v
-        A = queries::getA(state.graph, state.parameters, state.boundingChain, v, state.graph.getMaxDegree());
-        for (int w : state.graph.getNeighbours(v)) {
-            if (w > v) {
-                epoch.phaseOneHistory.emplace_back(state, w, A);
-                update(state, epoch.phaseOneHistory.back());
+    {
+        trace::Span span("phase one");
+        if (arena) {
+            arena->advise(Access::SEQUENTIAL);
+        }
+
+        BoundingList A(Kernel::maxColours(state));
+        long long updates = 0;
+        for (int v : state.freeVertices) {
+            // set A for the neighbourhood of v
+            queries::getA(state.graph, state.parameters, state.boundingChain, v, Kernel::maxDegree(state), A);
+            const ColourSet kept = history.keep(A);
+            for (int w : state.graph.getNeighbours(v)) {
+                if (w > v && state.isFree(w)) {
+                    update(state, history.compress(state, w, kept));
+                    updates++;
+                }
             }
+
+            update(state, history.contract(state, v));
+            updates++;
         }
 
-        epoch.phaseTwoHistory.emplace_back(state, v);
-        update(state, epoch.phaseTwoHistory.back());
+        if (span) {
+            span.set("nonSingleton", nonSingletons(state.boundingChain));
+            span.set("updates", updates);
+        }
     }
+    history.endPhaseOne();
 
     // Phase Two
-    int v;
-    for (int i = 0; i < phaseTwoIters; i++) {
-        // choose v uniformly at random
-        BoundingList bl(state.graph.size());
-        bl.flip();
-        v = uniformSample(bl);
-        epoch.phaseTwoHistory.emplace_back(state, v);
-        update(state, epoch.phaseTwoHistory.back());
+    // the vertices are independent of the updates, so they are drawn in batches; out-of-core,
+    // the pages each batch will touch are requested in sorted order before it is applied
+    static constexpr int batchSize = 4096;
+    std::vector<int> batch;
+    batch.reserve(std::clamp<std::int64_t>(phaseTwoIters, 0, batchSize));
+
+    trace::Span span("phase two");
+    if (arena) {
+        arena->advise(Access::RANDOM);
+    }
+
+    std::uniform_int_distribution<int> uniformVertex(0, static_cast<int>(state.freeVertices.size()) - 1);
+    for (std::int64_t i = 0; i < phaseTwoIters; i += batchSize) {
+        batch.resize(std::min<std::int64_t>(batchSize, phaseTwoIters - i));
+        for (int &v : batch) {
+            v = state.freeVertices[uniformVertex(mersene_gen)];
+        }
+
+        if (arena) {
+            prefetchPhaseTwo(state, batch.data(), batch.data() + batch.size());
+        }
+
+        for (int v : batch) {
+            update(state, history.contract(state, v));
+        }
     }
 
-    return epoch;
+    if (span) {
+        span.set("nonSingleton", nonSingletons(state.boundingChain));
+        span.set("updates", std::max<std::int64_t>(phaseTwoIters, 0));
+    }
+}
+
+/// \sa getPhaseTwoIters, for a graph with numNodes vertices and numEdges edges
+static std::int64_t getPhaseTwoIters(std::int64_t numNodes, std::int64_t numEdges, const Graph &graph,
+                                     const Parameters &parameters) {
+    const long double perPair = parameters.maxColours - graph.getMaxDegree() * (1 - parameters.temperature) /
+                                                            (parameters.maxColours -
+                                                             graph.getMaxDegree() * (3 - parameters.temperature));
+    return numNodes + 1 + numEdges + static_cast<std::int64_t>(pow(numNodes, 2) * perPair);
+}
+
+std::int64_t getPhaseTwoIters(const Graph &graph, const Parameters &parameters) {
+    return getPhaseTwoIters(graph.size(), graph.numEdges(), graph, parameters);
 }
 
-static int getPhaseTwoIters(const Graph &graph, const Parameters &parameters) {
-    return graph.size() + 1 + graph.numEdges() +
-           pow(graph.size(), 2) * (parameters.maxColours -
-                                   graph.getMaxDegree() * (1 - parameters.temperature) /
-                                       (parameters.maxColours - graph.getMaxDegree() * (3 - parameters.temperature)));
+std::int64_t getPhaseTwoIters(const Graph &graph, const Parameters &parameters, const std::vector<int> &freeVertices) {
+    std::vector<bool> free(graph.size());
+    for (int v : freeVertices) {
+        free[v] = true;
+    }
+
+    int numEdges = 0;
+    for (int v : freeVertices) {
+        for (int w : graph.getNeighbours(v)) {
+            numEdges += w > v && free[w];
+        }
+    }
+
+    // Delta stays that of the whole graph, since pinned neighbours still weigh on the free vertices
+    return freeVertices.empty() ? 0 : getPhaseTwoIters(freeVertices.size(), numEdges, graph, parameters);
 }
 
+/// the new bounding list of an update, built in place so that steady-state updates do not allocate
+static thread_local BoundingList nextBoundingList(0);
+
 // TODO: concept would be useful to remove this duplication
-void update(State &state, const CompressUpdate &update) {
-    state.boundingChain[update.v] =
-        update.getNewBoundingChain();  // bounding chain must be updated before the colouring
-    updateColouring(state, update);
+/// apply an update to the bounding chain; its colour is only evaluated during replay, see sample
+template<typename Kernel>
+void update(typename Kernel::state_t &state, const CompressUpdate<Kernel> &update) {
+    update.getNewBoundingChain(nextBoundingList);
+    state.setBoundingList(update.v, nextBoundingList);
 }
 
-void update(State &state, const ContractUpdate &update) {
-    state.boundingChain[update.v] =
-        update.getNewBoundingChain();  // bounding chain must be updated before the colouring
-    updateColouring(state, update);
+/// \sa update(typename Kernel::state_t &, const CompressUpdate<Kernel> &)
+template<typename Kernel>
+void update(typename Kernel::state_t &state, const ContractUpdate<Kernel> &update) {
+    update.getNewBoundingChain(nextBoundingList);
+    state.setBoundingList(update.v, nextBoundingList);
 }
 
 // TODO: concept would be useful to remove this duplication
-void updateColouring(State &state, const CompressUpdate &update) {
+template<typename Kernel>
+void updateColouring(typename Kernel::state_t &state, const CompressUpdate<Kernel> &update) {
     try {
         state.colouring[update.v] = update.getNewColour();
     } catch (const std::runtime_error &err) {
@@ -237,7 +979,8 @@ void updateColouring(State &state, const CompressUpdate &update) {
     }
 }
 
-void updateColouring(State &state, const ContractUpdate &update) {
+template<typename Kernel>
+void updateColouring(typename Kernel::state_t &state, const ContractUpdate<Kernel> &update) {
     try {
         state.colouring[update.v] = update.getNewColour();
     } catch (const std::runtime_error &err) {
@@ -249,7 +992,8 @@ void updateColouring(State &state, const ContractUpdate &update) {
     }
 }
 
-void updateColourWithEpoch(State &state, Epoch &epoch) {
+template<typename Kernel>
+void updateColourWithEpoch(typename Kernel::state_t &state, Epoch<Kernel> &epoch) {
     for (auto &iteration : epoch.phaseOneHistory) {
         updateColouring(state, iteration);
     }
@@ -1,11 +1,13 @@
 #include "state.hpp"
 
+#include "maths.hpp"
+
 /*************************************
  * Bounding List
  *************************************/
 
 BoundingList::BoundingList(const int maxColours, const std::vector<int>& boundingList)
-    : boost::dynamic_bitset<>(maxColours) {
+    : dynamic_bitset(maxColours) {
     for (int colour : boundingList) {
         if (colour < 0 || colour >= maxColours) {
             throw std::invalid_argument("Bounding list must be a subset of {0, ..., q - 1}");
@@ -40,6 +42,62 @@ BoundingList BoundingList::flip_copy() const {
     return result;
 }
 
+/*************************************
+ * Neighbour Counts
+ *************************************/
+
+NeighbourCounts::NeighbourCounts(const Graph& graph, int maxColours, const boundingchain_t& boundingChain,
+                                 const MappedAllocator<unsigned long>& allocator)
+    : maxColours(maxColours),
+      unfixedCounts(graph.size() * maxColours, 0, allocator),
+      fixedCounts(graph.size() * maxColours, 0, allocator),
+      unfixed(allocator) {
+    // emplaced, since copies of a list would be allocated on the heap
+    unfixed.reserve(graph.size());
+    for (int v = 0; v < graph.size(); v++) {
+        unfixed.emplace_back(maxColours, allocator);
+    }
+    recount(graph, boundingChain);
+}
+
+void NeighbourCounts::recount(const Graph& graph, const boundingchain_t& boundingChain) {
+    std::fill(unfixedCounts.begin(), unfixedCounts.end(), 0);
+    std::fill(fixedCounts.begin(), fixedCounts.end(), 0);
+    for (BoundingList& colours : unfixed) {
+        colours.reset();
+    }
+
+    for (int v = 0; v < graph.size(); v++) {
+        add(graph, v, boundingChain[v], 1);
+    }
+}
+
+void NeighbourCounts::replace(const Graph& graph, int v, const BoundingList& before, const BoundingList& after) {
+    if (before == after) {
+        return;
+    }
+    add(graph, v, before, -1);
+    add(graph, v, after, 1);
+}
+
+void NeighbourCounts::add(const Graph& graph, int v, const BoundingList& boundingList, int sign) {
+    if (boundingList.count() == 1) {
+        const int colour = boundingList.find_first();
+        for (int neighbour : graph.getNeighbours(v)) {
+            fixedCounts[neighbour * maxColours + colour] += sign;
+        }
+        return;
+    }
+
+    for (auto colour = boundingList.find_first(); colour != BoundingList::npos; colour = boundingList.find_next(colour)) {
+        for (int neighbour : graph.getNeighbours(v)) {
+            int& count = unfixedCounts[neighbour * maxColours + colour];
+            count += sign;
+            unfixed[neighbour][colour] = count > 0;
+        }
+    }
+}
+
 namespace queries {
 bool boundingChainIsConstant(const boundingchain_t& boundingChain) {
     return std::all_of(boundingChain.begin(), boundingChain.end(),
@@ -59,7 +117,7 @@ BoundingList getUnfixedColours(const Graph& graph, const Parameters& parameters,
             continue;
         }
         for (int colour = 0; colour < parameters.maxColours; colour++) {
-            result[colour] = boundingList[colour];
+            result[colour] |= boundingList[colour];
         }
     }
 
@@ -73,8 +131,9 @@ BoundingList getFixedColours(const Graph& graph, const Parameters& parameters, c
     return fixedColours;
 }
 
+template<typename Colour>
 std::vector<int> getNeighbourhoodColourCount(const Graph& graph, const Parameters& parameters,
-                                             const colouring_t& colouring, int v) {
+                                             const BasicStateColouring<Colour>& colouring, int v) {
     std::vector<int> count(parameters.maxColours);
     for (int neighbour : graph.getNeighbours(v)) {
         ++count[colouring[neighbour]];
@@ -82,30 +141,32 @@ std::vector<int> getNeighbourhoodColourCount(const Graph& graph, const Parameter
     return count;
 }
 
+template std::vector<int> getNeighbourhoodColourCount(const Graph&, const Parameters&,
+                                                      const BasicStateColouring<std::uint8_t>&, int);
+template std::vector<int> getNeighbourhoodColourCount(const Graph&, const Parameters&,
+                                                      const BasicStateColouring<std::uint16_t>&, int);
+template std::vector<int> getNeighbourhoodColourCount(const Graph&, const Parameters&, const BasicStateColouring<int>&,
+                                                      int);
+
 BoundingList getA(const Graph& graph, const Parameters& parameters, const boundingchain_t& boundingChain, int v,
                   int size) {
-    std::vector<int> vertices = graph.getNeighbours(v);
-
-    //	remove neighbours which are less than v
-    vertices.erase(std::remove_if(vertices.begin(), vertices.end(), [v](int w) { return w < v; }), vertices.end());
-
     BoundingList A{parameters.maxColours};
-    for (int vertex : vertices) {
-        A |= boundingChain[vertex];
-    }
-
-    //	ensure A has size at most size
-    A.makeAtMostKSet(size);
+    getA(graph, parameters, boundingChain, v, size, A);
+    return A;
+}
 
-    //	add more colours if A is smaller than size
-    for (int colour = 0, count = static_cast<int>(A.count()); size - count > 0; count++) {
-        while (A[colour]) {
-            colour++;
+void getA(const Graph& graph, const Parameters& parameters, const boundingchain_t& boundingChain, int v, int size,
+          BoundingList& A) {
+    //	union over the neighbours which are greater than v
+    A.resize(parameters.maxColours);
+    A.reset();
+    for (int vertex : graph.getNeighbours(v)) {
+        if (vertex >= v) {
+            A |= boundingChain[vertex];
         }
-        A.flip(colour);
     }
 
-    return A;
+    maths::fitA(A, parameters.maxColours, size);
 }
 
 int m_Q(const Graph& graph, const Parameters& parameters, const boundingchain_t& boundingChain, int v, int c) {
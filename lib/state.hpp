@@ -2,14 +2,20 @@
 #define POTTSSAMPLER_STATE_H
 
 #include <boost/dynamic_bitset.hpp>
+#include <cassert>
+#include <cstdint>
+#include <iterator>
 #include <memory>
 #include <random>
 #include <vector>
 
+#include "mapped.hpp"
 #include "sampler.hpp"
 
-struct BoundingList : boost::dynamic_bitset<> {
-    explicit BoundingList(const int maxColours) : boost::dynamic_bitset<>(maxColours) {}
+/// a set of colours; bounding lists owned by the State may live in a MappedArena
+struct BoundingList : boost::dynamic_bitset<unsigned long, MappedAllocator<unsigned long>> {
+    explicit BoundingList(const int maxColours, const allocator_type &allocator = {})
+        : dynamic_bitset(maxColours, 0, allocator) {}
 
     BoundingList(int maxColours, const std::vector<int> &boundingList);
 
@@ -17,26 +23,166 @@ struct BoundingList : boost::dynamic_bitset<> {
     BoundingList flip_copy() const;
 };
 
-using boundingchain_t = std::vector<BoundingList>;
+using boundingchain_t = std::vector<BoundingList, MappedAllocator<BoundingList>>;
+
+/// a set of colours held in the buffer of a ColourSets, so that the compress updates of an epoch refer to
+/// their set A rather than each keeping a copy
+class ColourSet {
+   public:
+    using block_type                  = BoundingList::block_type;
+    static constexpr int bitsPerBlock = BoundingList::bits_per_block;
+
+    ColourSet(const block_type *blocks, int size) : blocks(blocks), numColours(size) {}
+
+    int size() const { return numColours; }
+
+    bool operator[](int c) const { return blocks[c / bitsPerBlock] >> (c % bitsPerBlock) & 1; }
+
+    /// write the set to boundingList, which is only reallocated if it has the wrong size
+    void copyTo(BoundingList &boundingList) const {
+        boundingList.resize(numColours);
+        boost::from_block_range(blocks, blocks + boundingList.num_blocks(), boundingList);
+    }
+
+   private:
+    const block_type *blocks;
+    int numColours;
+};
+
+/// the sets of colours kept by an epoch, one after another in a buffer reserved up front
+class ColourSets {
+   public:
+    /// drop the sets, and make room for count sets of maxColours colours; the sets added until the next call
+    /// stay where they are
+    void reserve(int maxColours, int count) {
+        blocks.clear();
+        blocks.reserve(static_cast<std::size_t>(count) * blocksPerSet(maxColours));
+    }
+
+    /// \return a copy of set, valid until the next call to reserve or clear
+    ColourSet add(const BoundingList &set) {
+        assert(blocks.size() + set.num_blocks() <= blocks.capacity());
+        const std::size_t at = blocks.size();
+        boost::to_block_range(set, std::back_inserter(blocks));
+        return {blocks.data() + at, static_cast<int>(set.size())};
+    }
+
+    /// drop the sets, keeping the buffer
+    void clear() { blocks.clear(); }
+
+   private:
+    static std::size_t blocksPerSet(int maxColours) {
+        return (maxColours + ColourSet::bitsPerBlock - 1) / ColourSet::bitsPerBlock;
+    }
+
+    std::vector<ColourSet::block_type> blocks;
+};
+
+/// the colouring evolved by the sampler, which may live in a MappedArena
+/// \tparam Colour the integer type colours are stored in
+template<typename Colour>
+struct BasicStateColouring : std::vector<Colour, MappedAllocator<Colour>> {
+    using std::vector<Colour, MappedAllocator<Colour>>::vector;
+
+    BasicStateColouring(const colouring_t &colouring)
+        : std::vector<Colour, MappedAllocator<Colour>>(colouring.begin(), colouring.end()) {}
+};
+
+using StateColouring = BasicStateColouring<int>;
+
+/// for each vertex v and colour c, the number of neighbours of v whose bounding list has several colours
+/// including c, and the number whose bounding list is exactly {c}; kept in step with the bounding chain so
+/// that the unfixed colours and m_Q around a vertex are read rather than recomputed; the counts are 2 n q
+/// integers, so they are allocated with the bounding chain, in its MappedArena if it has one
+class NeighbourCounts {
+   public:
+    NeighbourCounts() = default;
+
+    NeighbourCounts(const Graph &, int maxColours, const boundingchain_t &,
+                    const MappedAllocator<unsigned long> &allocator = {});
+
+    /// count the bounding chain again from scratch, reusing the storage of the counts
+    void recount(const Graph &, const boundingchain_t &);
+
+    /// append the addresses of the counts read and written by an update at v, for prefetch
+    void addresses(int v, std::vector<const void *> &addresses) const {
+        addresses.push_back(&unfixedCounts[v * maxColours]);
+        addresses.push_back(&fixedCounts[v * maxColours]);
+        addresses.push_back(&unfixed[v]);
+    }
+
+    /// \sa queries::getUnfixedColours
+    const BoundingList &unfixedColours(int v) const { return unfixed[v]; }
+
+    /// \sa queries::m_Q
+    int m_Q(int v, int c) const { return fixedCounts[v * maxColours + c]; }
+
+    /// account for the bounding list of v changing from before to after, in O(deg(v)) for short lists
+    void replace(const Graph &, int v, const BoundingList &before, const BoundingList &after);
+
+   private:
+    /// add sign times the contribution of the bounding list of v to its neighbours
+    void add(const Graph &, int v, const BoundingList &, int sign);
+
+    int maxColours = 0;
+    std::vector<int, MappedAllocator<int>> unfixedCounts;
+    std::vector<int, MappedAllocator<int>> fixedCounts;
+
+    // the colours with a non-zero unfixed count, per vertex
+    boundingchain_t unfixed;
+};
+
+template<typename Colour>
+struct BasicState {
+    using colour_t = Colour;
 
-struct State {
     const Parameters parameters;
-    const Graph graph;
+    const Graph &graph;
+
+    BasicStateColouring<Colour> colouring{};
+    boundingchain_t boundingChain{};
+
+    // built once the bounding chain is initialised, and maintained by setBoundingList
+    NeighbourCounts neighbourCounts{};
+
+    // the vertices the sampler updates, in increasing order; the others are pinned to a colour, with a
+    // singleton bounding list, and pinned[v] is set for them (pinned is empty when no vertex is pinned)
+    std::vector<int> freeVertices{};
+    std::vector<bool> pinned{};
+
+    bool isFree(int v) const { return pinned.empty() || !pinned[v]; }
 
-    colouring_t colouring;
-    boundingchain_t boundingChain;
+    /// replace the bounding list of v, keeping neighbourCounts in step
+    void setBoundingList(int v, const BoundingList &boundingList) {
+        neighbourCounts.replace(graph, v, boundingChain[v], boundingList);
+        boundingChain[v] = boundingList;
+    }
 };
 
+using State = BasicState<int>;
+
+/// the number of phase two updates in each epoch; also used as the expected cost of a sample
+/// \note 64-bit, since it grows with the square of the number of vertices
+std::int64_t getPhaseTwoIters(const Graph &graph, const Parameters &parameters);
+
+/// \sa getPhaseTwoIters, for the subgraph induced by the free vertices when the others are pinned
+std::int64_t getPhaseTwoIters(const Graph &graph, const Parameters &parameters, const std::vector<int> &freeVertices);
+
 namespace queries {
 BoundingList getUnfixedColours(const Graph &, const Parameters &, const boundingchain_t &, int v);
 BoundingList getFixedColours(const Graph &, const Parameters &, const boundingchain_t &, int v);
-std::vector<int> getNeighbourhoodColourCount(const Graph &, const Parameters &, const colouring_t &, int v);
+template<typename Colour>
+std::vector<int> getNeighbourhoodColourCount(const Graph &, const Parameters &, const BasicStateColouring<Colour> &,
+                                             int v);
 
 /// Return the `minimal' set A maximally intersecting the bounding lists of
 /// greater neighbours of v \param v the vertex \param size the size of the
 /// set A to return \return a bitset describing the set A
 BoundingList getA(const Graph &, const Parameters &, const boundingchain_t &, int v, int size);
 
+/// \sa getA, writing the set to A, which is only reallocated if it has the wrong size
+void getA(const Graph &, const Parameters &, const boundingchain_t &, int v, int size, BoundingList &A);
+
 bool boundingChainIsConstant(const boundingchain_t &);
 
 /// Return the fixed count of c in the neighbourhood v
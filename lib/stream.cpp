@@ -0,0 +1,144 @@
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "kernel.hpp"
+#include "sampler.hpp"
+
+/*************************************
+ * Sample Stream
+ *************************************/
+
+template<typename Colour>
+struct BasicSampleStream<Colour>::Shared {
+    const Parameters parameters;
+    const Graph &graph;
+
+    std::mutex mutex{};
+    std::condition_variable ready{};  // signalled when a sample is completed, or a producer fails
+    std::condition_variable space{};  // signalled when a slot is freed, or the stream is stopped
+
+    // completed samples, oldest at head
+    std::vector<value_type> ring{};
+    int head  = 0;
+    int count = 0;
+
+    // samples in progress, which hold a slot of the ring
+    int reserved = 0;
+
+    // buffers handed back by the consumer, at most ring.size()
+    std::vector<value_type> spare{};
+
+    bool stopped = false;
+    std::exception_ptr error{};
+
+    std::vector<std::thread> producers{};
+
+    void produce() {
+        while (true) {
+            value_type colouring;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                space.wait(lock, [this]() { return stopped || count + reserved < ring.size(); });
+                if (stopped) {
+                    return;
+                }
+
+                ++reserved;
+                if (!spare.empty()) {
+                    colouring = std::move(spare.back());
+                    spare.pop_back();
+                }
+            }
+
+            colouring.resize(graph.size());
+            try {
+                // parameters were verified on construction, so a sample is always produced
+                sample(parameters, graph, colouring.data());
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                --reserved;
+                error   = error ? error : std::current_exception();
+                stopped = true;
+                ready.notify_all();
+                space.notify_all();
+                return;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                --reserved;
+                ring[(head + count) % ring.size()] = std::move(colouring);
+                ++count;
+            }
+            ready.notify_one();
+        }
+    }
+};
+
+template<typename Colour>
+BasicSampleStream<Colour>::BasicSampleStream(const Parameters &parameters, const Graph &graph, int numThreads,
+                                             int capacity)
+    : shared(new Shared{.parameters = parameters, .graph = graph}) {
+    if (const std::vector<std::string> violations = parameters.violations(graph); !violations.empty()) {
+        std::string message = "The parameters of a sample stream are not supported:";
+        for (const std::string &violation : violations) {
+            message += "\n" + violation;
+        }
+        throw std::invalid_argument(message);
+    }
+    if (!kernels::fits<Colour>(parameters.maxColours)) {
+        throw std::invalid_argument("The colour type is too narrow for " + std::to_string(parameters.maxColours) +
+                                    " colours.");
+    }
+
+    shared->ring.resize(std::max(capacity, 1));
+    for (int i = 0; i < std::max(numThreads, 1); i++) {
+        shared->producers.emplace_back(&Shared::produce, shared.get());
+    }
+}
+
+template<typename Colour>
+BasicSampleStream<Colour>::~BasicSampleStream() {
+    {
+        std::lock_guard<std::mutex> lock(shared->mutex);
+        shared->stopped = true;
+    }
+    shared->space.notify_all();
+    for (auto &producer : shared->producers) {
+        producer.join();
+    }
+}
+
+template<typename Colour>
+typename BasicSampleStream<Colour>::value_type BasicSampleStream<Colour>::next() {
+    std::unique_lock<std::mutex> lock(shared->mutex);
+    shared->ready.wait(lock, [this]() { return shared->count > 0 || shared->error; });
+    if (shared->count == 0) {
+        std::rethrow_exception(shared->error);
+    }
+
+    value_type colouring = std::move(shared->ring[shared->head]);
+    shared->head         = (shared->head + 1) % shared->ring.size();
+    --shared->count;
+    lock.unlock();
+
+    shared->space.notify_one();
+    return colouring;
+}
+
+template<typename Colour>
+void BasicSampleStream<Colour>::recycle(value_type &&colouring) {
+    std::lock_guard<std::mutex> lock(shared->mutex);
+    if (shared->spare.size() < shared->ring.size()) {
+        shared->spare.emplace_back(std::move(colouring));
+    }
+}
+
+template class BasicSampleStream<std::uint8_t>;
+template class BasicSampleStream<std::uint16_t>;
+template class BasicSampleStream<int>;
@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "sampler.hpp"
+#include "state.hpp"
+
+/*************************************
+ * Parameter Sweep
+ *************************************/
+
+void sweep(const Graph &graph, const std::vector<long double> &temperatures, const std::vector<int> &maxColours,
+           int numSamples, int numThreads, const std::function<void(const SweepPoint &)> &onPoint,
+           const std::function<void(const Parameters &, const std::vector<std::string> &)> &onSkipped) {
+    struct Point {
+        SweepPoint result;
+        std::int64_t cost;
+        int remaining;
+    };
+
+    auto skipped = [&onSkipped](const Parameters &parameters, const std::vector<std::string> &violations) {
+        if (onSkipped) {
+            onSkipped(parameters, violations);
+            return;
+        }
+        std::cerr << "Skipping T: " << parameters.temperature << ", q: " << parameters.maxColours << '.';
+        for (const std::string &violation : violations) {
+            std::cerr << ' ' << violation;
+        }
+        std::cerr << std::endl;
+    };
+
+    std::vector<Point> points;
+    for (int q : maxColours) {
+        for (long double temperature : temperatures) {
+            Parameters parameters{graph.size(), q, temperature};
+            if (const std::vector<std::string> violations = parameters.violations(graph); !violations.empty()) {
+                skipped(parameters, violations);
+            } else if (numSamples > 0) {
+                points.push_back({.result    = {parameters, std::vector<colouring_t>(numSamples)},
+                                  .cost      = getPhaseTwoIters(graph, parameters),
+                                  .remaining = numSamples});
+            }
+        }
+    }
+
+    // one job per (point, sample), longest expected first
+    std::vector<std::pair<int, int>> jobs;
+    for (int p = 0; p < points.size(); p++) {
+        for (int s = 0; s < numSamples; s++) {
+            jobs.emplace_back(p, s);
+        }
+    }
+    std::stable_sort(jobs.begin(), jobs.end(),
+                     [&points](const auto &a, const auto &b) { return points[a.first].cost > points[b.first].cost; });
+
+    std::atomic<std::size_t> next{0};
+    std::mutex mutex;
+    std::exception_ptr error;
+    auto worker = [&]() {
+        try {
+            for (std::size_t job = next++; job < jobs.size(); job = next++) {
+                auto [p, s]  = jobs[job];
+                Point &point = points[p];
+
+                // parameters were verified above, so a sample is always produced
+                colouring_t colouring = *sample(point.result.parameters, graph);
+
+                std::lock_guard<std::mutex> lock(mutex);
+                point.result.colourings[s] = std::move(colouring);
+                if (--point.remaining == 0) {
+                    onPoint(point.result);
+                    point.result.colourings = {};
+                }
+            }
+        } catch (...) {
+            // stop handing out jobs and rethrow on the calling thread
+            next = jobs.size();
+            std::lock_guard<std::mutex> lock(mutex);
+            error = error ? error : std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < std::max(numThreads, 1); i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
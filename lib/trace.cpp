@@ -0,0 +1,89 @@
+#include "trace.hpp"
+
+#include <mutex>
+#include <string>
+
+namespace trace {
+std::atomic<bool> recording{false};
+
+namespace {
+struct Event {
+    const char *name;
+    int thread;
+    std::chrono::steady_clock::time_point start, end;
+    std::vector<std::pair<const char *, long long>> args;
+};
+
+std::mutex mutex;
+std::chrono::steady_clock::time_point origin;
+std::vector<Event> events;
+
+// small, stable thread ids, so that each worker gets its own track
+std::atomic<int> nextThread{0};
+thread_local const int threadId = nextThread++;
+
+long long microseconds(std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+}
+}  // namespace
+
+Span::~Span() {
+    if (!active) {
+        return;
+    }
+
+    if (allocations::counting()) {
+        const allocations::Counts made = allocations::current() - before;
+        args.emplace_back("allocations", made.allocations);
+        args.emplace_back("bytes", made.bytes);
+    }
+
+    Event event{name, threadId, start, std::chrono::steady_clock::now(), std::move(args)};
+    std::lock_guard<std::mutex> lock(mutex);
+    if (recording) {
+        events.emplace_back(std::move(event));
+    }
+}
+}  // namespace trace
+
+void startTrace() {
+    std::lock_guard<std::mutex> lock(trace::mutex);
+    trace::events.clear();
+    trace::origin = std::chrono::steady_clock::now();
+    trace::recording = true;
+}
+
+void stopTrace(std::ostream &out) {
+    std::vector<trace::Event> events;
+    {
+        std::lock_guard<std::mutex> lock(trace::mutex);
+        trace::recording = false;
+        events.swap(trace::events);
+    }
+
+    // complete ("X") events, plus a name for the track of each thread
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    std::vector<bool> named;
+    const char *separator = "\n";
+    for (const trace::Event &event : events) {
+        if (event.thread >= named.size()) {
+            named.resize(event.thread + 1);
+        }
+        if (!named[event.thread]) {
+            named[event.thread] = true;
+            out << separator << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << event.thread
+                << ", \"args\": {\"name\": \"worker " << event.thread << "\"}}";
+            separator = ",\n";
+        }
+
+        out << separator << "{\"name\": \"" << event.name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << event.thread
+            << ", \"ts\": " << trace::microseconds(event.start - trace::origin)
+            << ", \"dur\": " << trace::microseconds(event.end - event.start) << ", \"args\": {";
+        for (std::size_t i = 0; i < event.args.size(); i++) {
+            out << (i ? ", " : "") << '"' << event.args[i].first << "\": " << event.args[i].second;
+        }
+        out << "}}";
+        separator = ",\n";
+    }
+    out << "\n]}\n";
+}
@@ -0,0 +1,58 @@
+#ifndef POTTSSAMPLER_TRACE_H
+#define POTTSSAMPLER_TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <utility>
+#include <vector>
+
+#include "allocations.hpp"
+#include "sampler.hpp"
+
+/// Timeline tracing of the perfect sampler, see startTrace. Spans are
+/// recorded by every thread into a single trace; when tracing is off a span
+/// costs one relaxed atomic load. When allocations are counted (see
+/// allocations.hpp), each span also records the number of allocations and
+/// bytes its thread made while it was open.
+namespace trace {
+extern std::atomic<bool> recording;
+
+inline bool enabled() { return recording.load(std::memory_order_relaxed); }
+
+/// a named interval on the timeline of the calling thread, from construction to destruction
+class Span {
+   public:
+    explicit Span(const char *name) : name(name), active(enabled()) {
+        if (active) {
+            // room for the arguments before counting starts, so that set does not count against the span
+            args.reserve(4);
+            before = allocations::current();
+            start  = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~Span();
+
+    Span(const Span &)            = delete;
+    Span &operator=(const Span &) = delete;
+
+    /// false when tracing was off as the span began; arguments need only be computed for active spans
+    explicit operator bool() const { return active; }
+
+    /// attach an argument shown with the span
+    void set(const char *key, long long value) {
+        if (active) {
+            args.emplace_back(key, value);
+        }
+    }
+
+   private:
+    const char *name;
+    const bool active;
+    std::chrono::steady_clock::time_point start;
+    allocations::Counts before;
+    std::vector<std::pair<const char *, long long>> args;
+};
+}  // namespace trace
+
+#endif  // POTTSSAMPLER_TRACE_H
@@ -1,31 +1,14 @@
 #include "update.hpp"
 
+#include "maths.hpp"
+
 /*************************************
  * Helpers
  *************************************/
 
-/// a method which applies the map c -> B^c to a vector
-/// \param B the base B
-/// \param counts a vector containing the exponent
-/// \return a vector of weights B^c
-std::vector<long double> pow(long double temperature, std::vector<int> counts) {
-    std::vector<long double> weights(counts.size());
-    std::transform(counts.begin(), counts.end(), weights.begin(),
-                   [temperature](int m_c) { return pow(temperature, m_c); });
-    return weights;
-}
-
-int sampleC2(const State &state, int v) {
-    std::vector<long double> weights(state.parameters.maxColours);
-    BoundingList bl = queries::getFixedColours(state.graph, state.parameters, state.boundingChain, v);
-    for (int c{}; c < bl.size(); ++c) {
-        if (bl[c]) {
-            weights[c] = pow(state.parameters.temperature,
-                             queries::m_Q(state.graph, state.parameters, state.boundingChain, v, c));
-        }
-    }
-
-    return sampleFromDist<long double>(weights);
+template<typename Kernel>
+int sampleC2(const typename Kernel::state_t &state, int v) {
+    return sampleFromDist(Kernel::fixedColourWeights(state, v));
 }
 
 /*************************************
@@ -36,34 +19,35 @@ int sampleC2(const State &state, int v) {
 /// \param m the model to update
 /// \param v the vertex to update
 /// \param c1 the proposal for the new colour of v
-ContractUpdate::ContractUpdate(const State &m, int v, int c1)
-    : Update{m, v, c1},
-      unfixedCount{
-          static_cast<int>(queries::getUnfixedColours(state.graph, state.parameters, state.boundingChain, v).count())},
-      c2{sampleC2(m, v)} {}
+template<typename Kernel>
+ContractUpdate<Kernel>::ContractUpdate(const state_t &m, int v, int c1)
+    : Update<Kernel>{m, v, c1},
+      unfixedCount{static_cast<int>(state.neighbourCounts.unfixedColours(v).count())},
+      c2{sampleC2<Kernel>(m, v)} {}
 
 /// choose propose a new colour for the vertex v
 /// \param m the model being updated
 /// \param v the vertex to update
 /// \return a new colour sampled uniformly from the set of unfixed colours at v
 /// \sa Model::bs_getUnfixedColours
-int ContractUpdate::proposeC1(const State &state, int v) {
-    return uniformSample(queries::getUnfixedColours(state.graph, state.parameters, state.boundingChain, v));
+template<typename Kernel>
+int ContractUpdate<Kernel>::proposeC1(const state_t &state, int v) {
+    return uniformSample(state.neighbourCounts.unfixedColours(v));
 }
 
 /// compute the cutoff used to choose between c1 and c2
-long double ContractUpdate::colouringGammaCutoff() const {
-    std::vector<long double> weights =
-        pow(state.parameters.temperature,
-            queries::getNeighbourhoodColourCount(state.graph, state.parameters, state.colouring, v));
-    long double norm = std::accumulate(weights.begin(), weights.end(), 0.0L);
-    return pow(state.parameters.temperature, weights[c1]) * unfixedCount / norm;
+template<typename Kernel>
+long double ContractUpdate<Kernel>::colouringGammaCutoff() const {
+    const auto &weights = Kernel::neighbourhoodWeights(state, v);
+    return maths::contractCutoff(weights[c1], unfixedCount,
+                                 maths::norm<long double>(weights.size(), [&weights](int c) { return weights[c]; }));
 }
 
 /// compute the cutoff used to set the bounding chain
-long double ContractUpdate::boundingListGammaCutoff() const {
-    return unfixedCount /
-           (state.parameters.maxColours - state.graph.getMaxDegree() * (1 - state.parameters.temperature));
+template<typename Kernel>
+long double ContractUpdate<Kernel>::boundingListGammaCutoff() const {
+    return maths::boundingListCutoff(unfixedCount, Kernel::maxColours(state), Kernel::maxDegree(state),
+                                     state.parameters.temperature);
 }
 
 /*************************************
@@ -72,39 +56,37 @@ long double ContractUpdate::boundingListGammaCutoff() const {
 
 /// compute the cutoff used to choose between c1 and c2
 /// \sa updateColouring
-long double CompressUpdate::gammaCutoff() const {
-    std::vector<long double> weights =
-        pow(state.parameters.temperature,
-            queries::getNeighbourhoodColourCount(state.graph, state.parameters, state.colouring, v));
-    long double norm = std::accumulate(weights.begin(), weights.end(), 0.0L);
-    return (state.parameters.maxColours - state.graph.getMaxDegree()) * weights[c1] / norm;
+template<typename Kernel>
+long double CompressUpdate<Kernel>::gammaCutoff() const {
+    const auto &weights = Kernel::neighbourhoodWeights(state, v);
+    return maths::compressCutoff(weights[c1], Kernel::maxColours(state), Kernel::maxDegree(state),
+                                 maths::norm<long double>(weights.size(), [&weights](int c) { return weights[c]; }));
 }
 
 /// generate a sample from the set A
-int CompressUpdate::sampleFromA() const {
-    std::vector<long double> weights =
-        pow(state.parameters.temperature,
-            queries::getNeighbourhoodColourCount(state.graph, state.parameters, state.colouring, v));
-
-    //	compute the denominator used to determine when to accept a colour as a sample
-    long double norm = 0;
-    for (int i = 0; i < weights.size(); i++) {
-        if (A[i]) {
-            norm += weights[i];
-        }
+template<typename Kernel>
+int CompressUpdate<Kernel>::sampleFromA() const {
+    const auto &weights = Kernel::neighbourhoodWeights(state, v);
+    const int colour    = maths::sampleWeighted(A, [&weights](int c) { return weights[c]; }, tau);
+    if (colour < 0) {
+        throw std::runtime_error("No sample generated from A (likely caused by rounding error).");
     }
+    return colour;
+}
 
-    long double tau_x_Denominator = tau * norm;
-    long double total             = 0;
-    for (int colour{}; colour < A.size(); ++colour) {
-        if (!A[colour]) continue;
-
-        if (total + weights[colour] > tau_x_Denominator) {
-            return colour;
-        }
-
-        total += weights[colour];
-    }
+/*************************************
+ * Instantiations
+ *************************************/
 
-    throw std::runtime_error("No sample generated from A (likely caused by rounding error).");
-}
+template class ContractUpdate<kernels::Dynamic<std::uint8_t>>;
+template class CompressUpdate<kernels::Dynamic<std::uint8_t>>;
+template class ContractUpdate<kernels::Dynamic<std::uint16_t>>;
+template class CompressUpdate<kernels::Dynamic<std::uint16_t>>;
+template class ContractUpdate<kernels::Dynamic<int>>;
+template class CompressUpdate<kernels::Dynamic<int>>;
+
+#define POTTS_KERNEL(q, delta)                             \
+    template class ContractUpdate<kernels::Fixed<q, delta>>; \
+    template class CompressUpdate<kernels::Fixed<q, delta>>;
+POTTS_KERNEL_LIST
+#undef POTTS_KERNEL
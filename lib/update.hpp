@@ -1,43 +1,59 @@
 #ifndef POTTSSAMPLER_UPDATE_H
 #define POTTSSAMPLER_UPDATE_H
 
-#include <vector>
-
+#include "kernel.hpp"
 #include "random.hpp"
 #include "sampler.hpp"
 #include "state.hpp"
 
-std::vector<long double> pow(long double temperature, std::vector<int> counts);
-
+/// \tparam Kernel the kernel used to compute weights (see kernel.hpp)
+template<typename Kernel>
 struct Update {
-    const State &state;
+    using state_t = typename Kernel::state_t;
+
+    const state_t &state;
     const int v;
     const int c1;
     const long double gamma = unitSample();
 };
 
-class ContractUpdate : public Update {
+/// \tparam Kernel the kernel used to compute weights (see kernel.hpp)
+template<typename Kernel = kernels::Dynamic<>>
+class ContractUpdate : public Update<Kernel> {
    public:
-    ContractUpdate(const State &state, int v) : ContractUpdate(state, v, proposeC1(state, v)) {}
+    using typename Update<Kernel>::state_t;
+    using Update<Kernel>::state;
+    using Update<Kernel>::v;
+    using Update<Kernel>::c1;
+    using Update<Kernel>::gamma;
+
+    ContractUpdate(const state_t &state, int v) : ContractUpdate(state, v, proposeC1(state, v)) {}
 
    protected:
-    ContractUpdate(const State &, int v, int c1);
+    ContractUpdate(const state_t &, int v, int c1);
 
    public:
     int getNewColour() const { return gamma < colouringGammaCutoff() ? c1 : c2; }
 
     BoundingList getNewBoundingChain() const {
-        return {
-            state.parameters.maxColours,
-            gamma > boundingListGammaCutoff() ? std::vector<int>{c2}
-                : std::vector<int>{c1, c2}
-        };
+        BoundingList boundingList(Kernel::maxColours(state));
+        getNewBoundingChain(boundingList);
+        return boundingList;
+    }
+
+    /// write the new bounding list of v to boundingList, which is only reallocated if it has the wrong size
+    void getNewBoundingChain(BoundingList &boundingList) const {
+        boundingList.resize(Kernel::maxColours(state));
+        boundingList.reset().set(c2);
+        if (gamma <= boundingListGammaCutoff()) {
+            boundingList.set(c1);
+        }
     }
 
    protected:
     long double colouringGammaCutoff() const;
     long double boundingListGammaCutoff() const;
-    static int proposeC1(const State &model, int v);
+    static int proposeC1(const state_t &model, int v);
 
     int unfixedCount;
 
@@ -45,28 +61,48 @@ class ContractUpdate : public Update {
     const int c2;
 };
 
-class CompressUpdate : public Update {
+/// \tparam Kernel the kernel used to compute weights (see kernel.hpp)
+template<typename Kernel = kernels::Dynamic<>>
+class CompressUpdate : public Update<Kernel> {
    public:
-    CompressUpdate(const State &state, int v, const BoundingList &bs_A)
-        : CompressUpdate(state, v, uniformSample(bs_A.flip_copy()), bs_A) {}
+    using typename Update<Kernel>::state_t;
+    using Update<Kernel>::state;
+    using Update<Kernel>::v;
+    using Update<Kernel>::c1;
+    using Update<Kernel>::gamma;
+
+    /// \param A the set A, kept by the history of the epoch (see ColourSets) for as long as the update
+    CompressUpdate(const state_t &state, int v, const ColourSet &A) : CompressUpdate(state, v, proposeC1(A), A) {}
 
    protected:
-    CompressUpdate(const State &state, int v, int c1, const BoundingList &bs_A) : Update{state, v, c1}, A(bs_A) {}
+    CompressUpdate(const state_t &state, int v, int c1, const ColourSet &A) : Update<Kernel>{state, v, c1}, A(A) {}
 
    public:
     int getNewColour() const { return gamma < gammaCutoff() ? c1 : sampleFromA(); }
 
     BoundingList getNewBoundingChain() const {
-        BoundingList bs = A;
-        bs.set(c1);
+        BoundingList bs(A.size());
+        getNewBoundingChain(bs);
         return bs;
     }
 
+    /// \sa ContractUpdate::getNewBoundingChain(BoundingList &)
+    void getNewBoundingChain(BoundingList &boundingList) const {
+        A.copyTo(boundingList);
+        boundingList.set(c1);
+    }
+
    protected:
     long double gammaCutoff() const;
     int sampleFromA() const;
 
-    const BoundingList A;
+    /// a colour outside A, uniformly at random
+    /// \sa uniformSampleUnset
+    static int proposeC1(const ColourSet &A) {
+        return sampleFromDist(A.size(), [&A](int c) { return static_cast<int>(!A[c]); });
+    }
+
+    const ColourSet A;
     const long double tau = unitSample();
 };
 
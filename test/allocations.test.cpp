@@ -0,0 +1,188 @@
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "allocations.hpp"
+#include "kernel.hpp"
+#include "random.hpp"
+#include "update.hpp"
+
+namespace {
+/// the allocations made by the calling thread while running f
+template<typename F>
+allocations::Counts allocated(F &&f) {
+    const allocations::Counts before = allocations::current();
+    f();
+    return allocations::current() - before;
+}
+
+/// a state on graph with every bounding list full
+template<typename Kernel>
+typename Kernel::state_t makeState(const Parameters &parameters, const Graph &graph) {
+    BoundingList full(parameters.maxColours);
+    full.set();
+
+    typename Kernel::state_t state{.parameters    = parameters,
+                                   .graph         = graph,
+                                   .colouring     = BasicStateColouring<typename Kernel::colour_t>(graph.size()),
+                                   .boundingChain = boundingchain_t(graph.size(), full)};
+    state.neighbourCounts = NeighbourCounts(graph, parameters.maxColours, state.boundingChain);
+    return state;
+}
+
+/// the updates of the sampler, applied as sample() applies them, then evaluated as the replay evaluates them
+template<typename Kernel>
+void checkUpdates(const Parameters &parameters, const Graph &graph) {
+    auto state = makeState<Kernel>(parameters, graph);
+    BoundingList boundingList(parameters.maxColours);
+    BoundingList A(parameters.maxColours);
+    ColourSets sets;
+    sets.reserve(parameters.maxColours, graph.size());
+
+    auto contract = [&](int v) {
+        const ContractUpdate<Kernel> update(state, v);
+        update.getNewBoundingChain(boundingList);
+        state.setBoundingList(v, boundingList);
+        state.colouring[v] = update.getNewColour();
+    };
+
+    auto compress = [&](int w, const ColourSet &kept) {
+        const CompressUpdate<Kernel> update(state, w, kept);
+        update.getNewBoundingChain(boundingList);
+        state.setBoundingList(w, boundingList);
+        state.colouring[w] = update.getNewColour();
+    };
+
+    // the compress updates of each vertex share its set A, kept in space reserved with the epoch
+    auto phaseOne = [&] {
+        sets.clear();
+        for (int v = 0; v < graph.size(); v++) {
+            queries::getA(graph, parameters, state.boundingChain, v, Kernel::maxDegree(state), A);
+            const ColourSet kept = sets.add(A);
+            for (int w : graph.getNeighbours(v)) {
+                if (w > v) {
+                    compress(w, kept);
+                }
+            }
+        }
+    };
+
+    // the first updates size the buffers the calling thread reuses
+    for (int v = 0; v < graph.size(); v++) {
+        contract(v);
+    }
+    phaseOne();
+
+    SECTION("contract updates") {
+        const allocations::Counts counts = allocated([&] {
+            for (int i = 0; i < 50 * graph.size(); i++) {
+                contract(i % graph.size());
+            }
+        });
+        CHECK(counts.allocations == 0);
+        CHECK(counts.bytes == 0);
+    }
+
+    SECTION("compress updates") {
+        const allocations::Counts counts = allocated([&] {
+            for (int i = 0; i < 50; i++) {
+                phaseOne();
+            }
+        });
+        CHECK(counts.allocations == 0);
+        CHECK(counts.bytes == 0);
+    }
+}
+
+/// \return the value of the integer argument key in the trace event on line, or -1 if it has none
+long long argument(const std::string &line, const std::string &key) {
+    const auto at = line.find('"' + key + "\": ");
+    return at == std::string::npos ? -1 : std::stoll(line.substr(at + key.size() + 4));
+}
+}  // namespace
+
+TEST_CASE("allocation counting", "[Allocations]") {
+    REQUIRE(allocations::counting());
+
+    // the vectors outlive the counting, so that the allocations cannot be elided
+    SECTION("allocations and their bytes are counted") {
+        std::vector<int> values;
+        const allocations::Counts counts = allocated([&values] { values.resize(100); });
+        CHECK(counts.allocations == 1);
+        CHECK(counts.bytes == 100 * sizeof(int));
+    }
+
+    SECTION("only the allocations of the calling thread are counted") {
+        std::vector<int> values;
+        allocations::Counts inner;
+        const allocations::Counts counts = allocated([&] {
+            std::thread thread([&] { inner = allocated([&values] { values.resize(1000); }); });
+            thread.join();
+        });
+        CHECK(inner.allocations == 1);
+        CHECK(counts.bytes < 1000 * sizeof(int));
+    }
+}
+
+TEST_CASE("steady-state updates do not allocate", "[Allocations]") {
+    SECTION("generic kernel") {
+        const Graph graph = Graph::random(30, 4, 1);
+        checkUpdates<kernels::Dynamic<std::uint8_t>>(Parameters{graph.size(), 11, 0.9}, graph);
+    }
+
+    SECTION("fixed kernel") {
+        const Graph graph = Graph::random(30, 3, 1);
+        checkUpdates<kernels::Fixed<7, 3>>(Parameters{graph.size(), 7, 0.9}, graph);
+    }
+
+    SECTION("sampling from a distribution") {
+        BoundingList boundingList(9);
+        boundingList.set(2).set(5);
+        const std::vector<long double> weights{0.5, 0, 1, 0.25};
+
+        const allocations::Counts counts = allocated([&] {
+            for (int i = 0; i < 100; i++) {
+                uniformSample(boundingList);
+                uniformSampleUnset(boundingList);
+                sampleFromDist(weights);
+            }
+        });
+        CHECK(counts.allocations == 0);
+    }
+}
+
+TEST_CASE("phase two and the replay do not allocate", "[Allocations]") {
+    // the trace records the allocations of each span; with the full history, the updates of phase two are
+    // stored in space reserved with the epoch
+    for (const auto &[maxColours, maxDegree] : {std::pair{7, 3}, std::pair{11, 4}}) {
+        const Graph graph = Graph::random(30, maxDegree, 2);
+        const Parameters params{graph.size(), maxColours, 0.9};
+
+        // sizes the buffers the calling thread reuses
+        REQUIRE(sample(params, graph));
+
+        startTrace();
+        REQUIRE(sample(params, graph, 3, SamplingOptions{}));
+        std::ostringstream out;
+        stopTrace(out);
+
+        std::istringstream events(out.str());
+        int spans = 0;
+        for (std::string line; std::getline(events, line);) {
+            if (line.find("\"name\": \"phase two\"") != std::string::npos ||
+                line.find("\"name\": \"replay\"") != std::string::npos) {
+                spans++;
+                CHECK(argument(line, "allocations") == 0);
+                CHECK(argument(line, "bytes") == 0);
+            }
+            if (line.find("\"name\": \"phase two\"") != std::string::npos) {
+                CHECK(argument(line, "updates") > 0);
+            }
+        }
+        CHECK(spans > 3);
+    }
+}
@@ -0,0 +1,87 @@
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "potts.h"
+
+
+TEST_CASE("C interface", "[CApi]") {
+    // a cycle on 5 vertices in compressed sparse rows
+    const int numNodes = 5;
+    std::vector<std::int64_t> offsets{0, 2, 4, 6, 8, 10};
+    std::vector<std::int32_t> targets{1, 4, 0, 2, 1, 3, 2, 4, 3, 0};
+
+    potts_sampler *sampler = nullptr;
+    REQUIRE(potts_sampler_create(numNodes, offsets.data(), targets.data(), 7, 0.95, &sampler) == POTTS_OK);
+    REQUIRE(sampler);
+
+    SECTION("samples are written to the caller's buffer") {
+        std::vector<std::uint8_t> out(3 * numNodes, 0xFF);
+        REQUIRE(potts_sample_uint8(sampler, 3, out.data()) == POTTS_OK);
+        for (std::uint8_t colour : out) {
+            CHECK(colour < 7);
+        }
+    }
+
+    SECTION("seeded samples do not depend on the number of threads") {
+        std::vector<std::int32_t> serial(8 * numNodes), parallel(8 * numNodes);
+        REQUIRE(potts_sampler_set_seed(sampler, 42) == POTTS_OK);
+        REQUIRE(potts_sample_int32(sampler, 8, serial.data()) == POTTS_OK);
+
+        REQUIRE(potts_sampler_set_seed(sampler, 42) == POTTS_OK);
+        REQUIRE(potts_sampler_set_threads(sampler, 3) == POTTS_OK);
+        REQUIRE(potts_sample_int32(sampler, 5, parallel.data()) == POTTS_OK);
+        REQUIRE(potts_sample_int32(sampler, 3, parallel.data() + 5 * numNodes) == POTTS_OK);
+        CHECK(serial == parallel);
+    }
+
+    SECTION("seeded samples leave the generator of the calling thread as it was") {
+        // unseeded, the samples come from the generator of the calling thread
+        potts_sampler *unseeded = nullptr;
+        REQUIRE(potts_sampler_create(numNodes, offsets.data(), targets.data(), 7, 0.95, &unseeded) == POTTS_OK);
+        REQUIRE(potts_sampler_set_seed(sampler, 42) == POTTS_OK);
+
+        std::vector<std::int32_t> seeded(numNodes), first(8 * numNodes), second(8 * numNodes);
+        REQUIRE(potts_sample_int32(sampler, 1, seeded.data()) == POTTS_OK);
+        REQUIRE(potts_sample_int32(unseeded, 8, first.data()) == POTTS_OK);
+
+        REQUIRE(potts_sampler_set_seed(sampler, 42) == POTTS_OK);
+        REQUIRE(potts_sample_int32(sampler, 1, seeded.data()) == POTTS_OK);
+        REQUIRE(potts_sample_int32(unseeded, 8, second.data()) == POTTS_OK);
+        CHECK(first != second);
+        potts_sampler_destroy(unseeded);
+    }
+
+    SECTION("invalid arguments are reported") {
+        CHECK(potts_sample_int32(sampler, -1, nullptr) == POTTS_INVALID_ARGUMENT);
+        CHECK(potts_sampler_set_threads(sampler, 0) == POTTS_INVALID_ARGUMENT);
+        CHECK(potts_last_error()[0] != '\0');
+
+        potts_sampler *other = nullptr;
+        targets[0] = numNodes;
+        CHECK(potts_sampler_create(numNodes, offsets.data(), targets.data(), 7, 0.95, &other) ==
+              POTTS_INVALID_ARGUMENT);
+        CHECK(other == nullptr);
+
+        // the reason is only reported through potts_last_error
+        targets[0] = 1;
+        std::ostringstream printed;
+        std::streambuf *const cout = std::cout.rdbuf(printed.rdbuf());
+        const potts_status status  = potts_sampler_create(numNodes, offsets.data(), targets.data(), 4, 0.95, &other);
+        std::cout.rdbuf(cout);
+        CHECK(status == POTTS_UNSUPPORTED_PARAMETERS);
+        CHECK(other == nullptr);
+        CHECK(printed.str().empty());
+        CHECK(potts_last_error()[0] != '\0');
+
+        REQUIRE(potts_sampler_create(numNodes, offsets.data(), targets.data(), 300, 0.95, &other) == POTTS_OK);
+        std::vector<std::uint8_t> out(numNodes);
+        CHECK(potts_sample_uint8(other, 1, out.data()) == POTTS_COLOUR_OVERFLOW);
+        potts_sampler_destroy(other);
+    }
+
+    potts_sampler_destroy(sampler);
+}
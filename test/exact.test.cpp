@@ -0,0 +1,194 @@
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "exact.hpp"
+
+namespace {
+/// check samples against the exact distribution on graph, both cell by cell and through the number of
+/// monochromatic edges, which detects a small change of B; the total variation is only reported, since at the
+/// sample sizes of these tests it barely moves when B does
+void checkExact(const exact::Distribution &distribution, const Graph &graph, const std::vector<colouring_t> &samples) {
+    const exact::Result cells = exact::test(distribution, samples);
+    const exact::Result edges = exact::testMonochromaticEdges(distribution, graph, samples);
+    INFO("chi-square = " << cells.chiSquare << " on " << cells.degreesOfFreedom << " degrees of freedom, "
+                         << "total variation = " << cells.totalVariation << " (" << cells.expectedTotalVariation
+                         << " expected); monochromatic edges: chi-square = " << edges.chiSquare << " on "
+                         << edges.degreesOfFreedom << " degrees of freedom");
+    CHECK(cells.pValue > 1e-4);
+    CHECK(edges.pValue > 1e-4);
+}
+}  // namespace
+
+TEST_CASE("exact enumeration", "[Exact]") {
+    auto params = Parameters{4, 7, 0.7};
+    auto graph  = Graph(params.numNodes, Graph::Type::COMPLETE);
+
+    const exact::Distribution distribution = exact::enumerate(params, graph, 3);
+
+    SECTION("the distribution is the Potts distribution") {
+        REQUIRE(distribution.probabilities.size() == 7 * 7 * 7 * 7);
+        CHECK(std::accumulate(distribution.probabilities.begin(), distribution.probabilities.end(), 0.0) ==
+              Catch::Approx(1));
+
+        // a proper colouring against one with all 6 edges monochromatic
+        const double proper = distribution.probabilities[distribution.index({0, 1, 2, 3})];
+        const double constant = distribution.probabilities[distribution.index({5, 5, 5, 5})];
+        CHECK(constant / proper == Catch::Approx(std::pow(0.7, 6)));
+        CHECK(distribution.probabilities[distribution.index({1, 1, 2, 3})] / proper == Catch::Approx(0.7));
+    }
+
+    SECTION("the distribution does not depend on the number of threads") {
+        CHECK(exact::enumerate(params, graph, 1).probabilities == distribution.probabilities);
+    }
+
+    SECTION("the tests accept exact samples and reject biased ones") {
+        std::mt19937 gen{1};
+        std::discrete_distribution<std::size_t> exactIndex(distribution.probabilities.begin(),
+                                                           distribution.probabilities.end());
+        std::uniform_int_distribution<std::size_t> uniformIndex(0, distribution.probabilities.size() - 1);
+        auto draw = [&](auto &&index) {
+            std::vector<colouring_t> samples;
+            for (int i = 0; i < 10000; i++) {
+                std::size_t k = index(gen);
+                colouring_t &colouring = samples.emplace_back(params.numNodes);
+                for (int &colour : colouring) {
+                    colour = k % params.maxColours;
+                    k /= params.maxColours;
+                }
+            }
+            return samples;
+        };
+
+        exact::Result result = exact::test(distribution, draw(exactIndex));
+        CHECK(result.pValue > 1e-4);
+        CHECK(result.totalVariation < 1.1 * result.expectedTotalVariation);
+        CHECK(exact::testMonochromaticEdges(distribution, graph, draw(exactIndex)).pValue > 1e-4);
+
+        result = exact::test(distribution, draw(uniformIndex));
+        CHECK(result.pValue < 1e-4);
+        CHECK(result.totalVariation > 1.1 * result.expectedTotalVariation);
+
+        // a small change of B is missed cell by cell, but not through the monochromatic edges
+        const exact::Distribution warmer = exact::enumerate(Parameters{4, 7, 0.85}, graph, 1);
+        std::discrete_distribution<std::size_t> warmerIndex(warmer.probabilities.begin(), warmer.probabilities.end());
+        CHECK(exact::testMonochromaticEdges(distribution, graph, draw(warmerIndex)).pValue < 1e-4);
+    }
+
+    SECTION("the expected total variation holds for sparse cells") {
+        // with far fewer samples than cells, most cells are empty and the total variation is near 1
+        std::mt19937 gen{2};
+        std::discrete_distribution<std::size_t> exactIndex(distribution.probabilities.begin(),
+                                                           distribution.probabilities.end());
+        std::vector<colouring_t> samples;
+        for (int i = 0; i < 100; i++) {
+            std::size_t k = exactIndex(gen);
+            colouring_t &colouring = samples.emplace_back(params.numNodes);
+            for (int &colour : colouring) {
+                colour = k % params.maxColours;
+                k /= params.maxColours;
+            }
+        }
+
+        const exact::Result result = exact::test(distribution, samples);
+        CHECK(result.totalVariation == Catch::Approx(result.expectedTotalVariation).epsilon(0.05));
+    }
+}
+
+
+TEST_CASE("sampler matches the exact distribution", "[Exact][Sampler]") {
+    // (q, Delta) = (7, 3) runs a fixed kernel and (9, 3) the generic one
+    const Parameters points[] = {{4, 7, 0.7}, {4, 9, 0.8}};
+    auto graph = Graph(4, Graph::Type::COMPLETE);
+
+    for (const Parameters &params : points) {
+        INFO("q = " << params.maxColours);
+        const exact::Distribution distribution = exact::enumerate(params, graph, 2);
+
+        seed(1, params.maxColours);
+        auto samples = sample(params, graph, 10000, SamplingOptions{});
+        REQUIRE(samples);
+        checkExact(distribution, graph, samples->colourings);
+    }
+}
+
+
+TEST_CASE("conditional samples match the exact conditional distribution", "[Exact][Sampler]") {
+    auto params = Parameters{5, 9, 0.8};
+    auto graph  = Graph(params.numNodes, Graph::Type::COMPLETE);
+
+    // K5 has Delta = 4, so q = 9 passes verification; vertices 1 and 3 are pinned
+    SamplingOptions options;
+    options.pinned = {-1, 4, -1, 4, -1};
+
+    exact::Distribution distribution = exact::enumerate(params, graph, 2);
+    std::vector<int> colouring(params.numNodes);
+    double total = 0;
+    for (std::size_t k = 0; k < distribution.probabilities.size(); k++) {
+        // colourings are indexed with vertex 0 as the least significant digit
+        std::size_t index = k;
+        for (int &colour : colouring) {
+            colour = index % params.maxColours;
+            index /= params.maxColours;
+        }
+        if (colouring[1] != 4 || colouring[3] != 4) {
+            distribution.probabilities[k] = 0;
+        }
+        total += distribution.probabilities[k];
+    }
+    for (double &probability : distribution.probabilities) {
+        probability /= total;
+    }
+
+    seed(2, 0);
+    auto samples = sample(params, graph, 4000, options);
+    REQUIRE(samples);
+    checkExact(distribution, graph, samples->colourings);
+}
+
+
+TEST_CASE("lockstep engine matches the exact distribution", "[Exact][Lockstep]") {
+    const Parameters points[] = {{4, 7, 0.7}, {4, 9, 0.8}};
+    auto graph = Graph(4, Graph::Type::COMPLETE);
+
+    for (const Parameters &params : points) {
+        const exact::Distribution distribution = exact::enumerate(params, graph, 2);
+
+        INFO("q = " << params.maxColours);
+        seed(3, params.maxColours);
+        auto samples = sample(params, graph, 10000, SamplingOptions{.engine = SamplingOptions::Engine::LOCKSTEP});
+        REQUIRE(samples);
+        checkExact(distribution, graph, samples->colourings);
+    }
+}
+
+
+TEST_CASE("samplers match the exact distribution on a non-regular graph", "[Exact][Sampler][Lockstep]") {
+    // K4 without the edge {0, 1}, and a pendant vertex 4 on vertex 0: the degrees are 3, 2, 3, 3 and 1; the
+    // reverse Cuthill-McKee ordering relabels the vertices, so the samples are only right if they are mapped back
+    const std::vector<Graph::edge_t> edges{{0, 2}, {0, 3}, {1, 2}, {1, 3}, {2, 3}, {0, 4}};
+    const Graph graph(5, edges, Graph::Ordering::REVERSE_CUTHILL_MCKEE);
+    REQUIRE(graph.getMaxDegree() == 3);
+
+    const Parameters params{5, 7, 0.7};
+    const exact::Distribution distribution = exact::enumerate(params, graph, 2);
+    REQUIRE(distribution.probabilities.size() == 7 * 7 * 7 * 7 * 7);
+
+    SECTION("perfect engine") {
+        seed(4, 0);
+        auto samples = sample(params, graph, 10000, SamplingOptions{});
+        REQUIRE(samples);
+        checkExact(distribution, graph, samples->colourings);
+    }
+
+    SECTION("lockstep engine") {
+        seed(4, 1);
+        auto samples = sample(params, graph, 10000, SamplingOptions{.engine = SamplingOptions::Engine::LOCKSTEP});
+        REQUIRE(samples);
+        checkExact(distribution, graph, samples->colourings);
+    }
+}
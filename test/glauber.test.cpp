@@ -0,0 +1,59 @@
+#include <cmath>
+#include <vector>
+
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "glauber.hpp"
+#include "sampler.hpp"
+
+
+TEST_CASE("glauber diagnostics", "[Glauber]") {
+    SECTION("autocorrelation time") {
+        CHECK(glauber::autocorrelationTime({2, 2, 2, 2}) == 1);
+        CHECK(glauber::autocorrelationTime({0, 1, 0, 1, 0, 1, 0, 1}) == 1);
+
+        // a slowly varying series is strongly correlated
+        std::vector<double> series;
+        for (int i = 0; i < 200; i++) {
+            series.push_back(i / 50);
+        }
+        CHECK(glauber::autocorrelationTime(series) > 5);
+    }
+
+    SECTION("Gelman-Rubin") {
+        std::vector<double> chain{0, 1, 2, 1, 0, 1, 2, 1};
+        CHECK(glauber::gelmanRubin({chain, chain}) == Catch::Approx(std::sqrt(7.0 / 8)));
+        CHECK(glauber::gelmanRubin({{0, 1, 0, 1}, {10, 11, 10, 11}}) > 2);
+        CHECK(std::isnan(glauber::gelmanRubin({chain})));
+    }
+
+    SECTION("energy counts monochromatic edges") {
+        Graph graph(4, Graph::Type::CYCLE);
+        CHECK(glauber::energy(graph, {0, 0, 1, 0}) == 2);
+        CHECK(glauber::energy(graph, {0, 1, 0, 1}) == 0);
+    }
+}
+
+TEST_CASE("glauber engine", "[Glauber]") {
+    // these parameters are rejected by the perfect sampler
+    auto params = Parameters{6, 3, 0.5};
+    auto graph = Graph(params.numNodes, Graph::Type::CYCLE);
+
+    SamplingOptions options{.engine = SamplingOptions::Engine::GLAUBER, .sweeps = 5, .thinning = 2, .chains = 3};
+    auto samples = sample(params, graph, 10, options);
+
+    REQUIRE(samples);
+    REQUIRE(samples->colourings.size() == 10);
+    for (const auto &colouring : samples->colourings) {
+        REQUIRE(colouring.size() == params.numNodes);
+        for (int colour : colouring) {
+            CHECK((colour >= 0 && colour < params.maxColours));
+        }
+    }
+
+    REQUIRE(samples->diagnostics);
+    CHECK(samples->diagnostics->autocorrelationTime >= 1);
+
+    CHECK_FALSE(sample(params, graph, 1, SamplingOptions{}));
+}
@@ -0,0 +1,64 @@
+#include <type_traits>
+
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include "kernel.hpp"
+#include "state.hpp"
+
+
+TEST_CASE("kernels", "[Kernel]") {
+    auto params = Parameters{7, 7, 0.9};
+    auto graph = Graph(params.numNodes, Graph::Type::CYCLE);
+    BoundingList defaultBL(params.maxColours);
+    defaultBL.set();
+
+    using Fixed   = kernels::Fixed<7, 3>;
+    using Dynamic = kernels::Dynamic<Fixed::colour_t>;
+
+    Fixed::state_t state{.parameters    = params,
+                         .graph         = graph,
+                         .colouring     = colouring_t{0, 1, 1, 3, 6, 6, 2},
+                         .boundingChain = boundingchain_t(params.numNodes, defaultBL)};
+    state.boundingChain[2] = BoundingList(params.maxColours, std::vector<int>{4});
+    state.boundingChain[4] = BoundingList(params.maxColours, std::vector<int>{4});
+    state.neighbourCounts  = NeighbourCounts(graph, params.maxColours, state.boundingChain);
+
+    SECTION("fixed kernel reports the compile-time constants") {
+        CHECK(Fixed::maxColours(state) == 7);
+        CHECK(Fixed::maxDegree(state) == 3);
+    }
+
+    SECTION("fixed and dynamic kernels compute the same weights") {
+        for (int v = 0; v < params.numNodes; v++) {
+            auto expected = Dynamic::neighbourhoodWeights(state, v);
+            auto actual   = Fixed::neighbourhoodWeights(state, v);
+            for (int c = 0; c < params.maxColours; c++) {
+                CHECK(actual[c] == Catch::Approx(expected[c]));
+            }
+
+            expected = Dynamic::fixedColourWeights(state, v);
+            actual   = Fixed::fixedColourWeights(state, v);
+            for (int c = 0; c < params.maxColours; c++) {
+                CHECK(actual[c] == Catch::Approx(expected[c]));
+            }
+        }
+    }
+
+    SECTION("dispatch selects a fixed kernel for a configured (q, Delta)") {
+        auto isFixed = [](auto kernel) { return std::is_same_v<decltype(kernel), Fixed>; };
+        CHECK(kernels::dispatch(params, graph, isFixed));
+        CHECK_FALSE(kernels::dispatch(Parameters{7, 8, 0.9}, graph, isFixed));
+    }
+
+    SECTION("kernels store colours in the narrowest type holding q colours") {
+        CHECK(std::is_same_v<Fixed::colour_t, std::uint8_t>);
+        CHECK(std::is_same_v<kernels::colour_for_t<256>, std::uint8_t>);
+        CHECK(std::is_same_v<kernels::colour_for_t<257>, std::uint16_t>);
+        CHECK(std::is_same_v<kernels::colour_for_t<65537>, int>);
+
+        auto colourType = [](auto kernel) { return sizeof(typename decltype(kernel)::colour_t); };
+        CHECK(kernels::dispatch(Parameters{7, 8, 0.9}, graph, colourType) == 1);
+        CHECK(kernels::dispatch(Parameters{7, 300, 0.9}, graph, colourType) == 2);
+    }
+}
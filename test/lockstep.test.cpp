@@ -0,0 +1,59 @@
+#include <cstdint>
+#include <stdexcept>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "lockstep.hpp"
+#include "sampler.hpp"
+
+
+TEST_CASE("lockstep engine", "[Lockstep]") {
+    auto params = Parameters{10, 9, 0.9};
+    auto graph  = Graph(params.numNodes, Graph::Type::CYCLE, Graph::Ordering::BFS);
+    SamplingOptions options{.engine = SamplingOptions::Engine::LOCKSTEP};
+
+    SECTION("every sample is returned once lanes are refilled and masked off") {
+        // more samples than lanes, and not a multiple of them
+        const int numSamples = 2 * lockstep::lanes + 3;
+        auto samples = sample<std::uint8_t>(params, graph, numSamples, options);
+        REQUIRE(samples);
+        REQUIRE(samples->colourings.size() == numSamples);
+        REQUIRE(samples->epochs.size() == numSamples);
+        for (const auto &colouring : samples->colourings) {
+            REQUIRE(colouring.size() == params.numNodes);
+            for (int colour : colouring) {
+                CHECK(colour < params.maxColours);
+            }
+        }
+        for (int epochs : samples->epochs) {
+            CHECK(epochs >= 1);
+        }
+        CHECK_FALSE(samples->diagnostics);
+    }
+
+    SECTION("fewer samples than lanes") {
+        auto samples = sample(params, graph, 3, options);
+        REQUIRE(samples);
+        CHECK(samples->colourings.size() == 3);
+        CHECK(sample(params, graph, 0, options)->colourings.empty());
+    }
+
+    SECTION("the lockstep engine requires verified parameters and at most 64 colours") {
+        CHECK_FALSE(sample(Parameters{10, 4, 0.9}, graph, 4, options));
+
+        Samples samples;
+        CHECK_THROWS_AS(lockstep::run(Parameters{10, 65, 0.9}, graph, 1, samples), std::invalid_argument);
+        lockstep::run(Parameters{10, lockstep::maxColours, 0.9}, graph, 1, samples);
+        CHECK(samples.colourings.size() == 1);
+    }
+
+    SECTION("options only the perfect engine supports are rejected") {
+        SamplingOptions regenerated = options;
+        regenerated.history         = SamplingOptions::History::REGENERATED;
+        CHECK_THROWS_AS(sample(params, graph, 1, regenerated), std::invalid_argument);
+
+        SamplingOptions stored  = options;
+        stored.storageDirectory = ".";
+        CHECK_THROWS_AS(sample(params, graph, 1, stored), std::invalid_argument);
+    }
+}
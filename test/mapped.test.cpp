@@ -0,0 +1,100 @@
+#include <filesystem>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "allocations.hpp"
+#include "mapped.hpp"
+#include "sampler.hpp"
+#include "state.hpp"
+
+
+TEST_CASE("memory-mapped storage", "[Mapped]") {
+    const std::string directory = std::filesystem::temp_directory_path();
+
+    SECTION("arena allocations are aligned and page-backed") {
+        MappedArena arena(directory, pageSize());
+        std::vector<int, MappedAllocator<int>> values(1000, 7, MappedAllocator<int>(&arena));
+        CHECK(reinterpret_cast<std::uintptr_t>(values.data()) % pageSize() == 0);
+        CHECK(values[999] == 7);
+
+        // larger than a chunk
+        std::vector<double, MappedAllocator<double>> large(pageSize(), 1.5, MappedAllocator<double>(&arena));
+        CHECK(large.back() == 1.5);
+    }
+
+    SECTION("copies of arena containers are allocated on the heap") {
+        MappedArena arena(directory);
+        BoundingList boundingList(9, MappedAllocator<unsigned long>(&arena));
+        boundingList.set(4);
+
+        BoundingList copy = boundingList;
+        CHECK(copy == boundingList);
+        CHECK(copy.get_allocator().arena == nullptr);
+    }
+
+    SECTION("neighbour counts are allocated with the bounding chain") {
+        MappedArena arena(directory);
+        const MappedAllocator<unsigned long> allocator(&arena);
+        const Graph graph = Graph::random(200, 4, 1);
+
+        boundingchain_t boundingChain(allocator);
+        boundingChain.reserve(graph.size());
+        for (int v = 0; v < graph.size(); v++) {
+            boundingChain.emplace_back(11, allocator).set();
+        }
+
+        const allocations::Counts before = allocations::current();
+        NeighbourCounts counts(graph, 11, boundingChain, allocator);
+        NeighbourCounts moved;
+        moved = std::move(counts);
+        moved.recount(graph, boundingChain);
+        CHECK((allocations::current() - before).bytes == 0);
+        CHECK(moved.unfixedColours(0).count() == 11);
+    }
+
+    SECTION("graphs can be saved and mapped") {
+        const std::string path = directory + "/potts-graph-test.bin";
+        Graph graph = Graph::random(50, 4, 1, Graph::Ordering::REVERSE_CUTHILL_MCKEE);
+        graph.save(path);
+
+        Graph mapped = Graph::map(path);
+        REQUIRE(mapped.size() == graph.size());
+        CHECK(mapped.numEdges() == graph.numEdges());
+        CHECK(mapped.getMaxDegree() == graph.getMaxDegree());
+        for (int v = 0; v < graph.size(); v++) {
+            auto neighbours = graph.getNeighbours(v);
+            CHECK(mapped.getNeighbours(v) == std::vector<int>(neighbours.begin(), neighbours.end()));
+            CHECK(mapped.toOriginal(v) == graph.toOriginal(v));
+        }
+
+        SECTION("a mapped graph can be replicated onto the heap") {
+            Graph replica = mapped.replicate();
+            std::filesystem::remove(path);
+
+            REQUIRE(replica.size() == graph.size());
+            CHECK(replica.getMaxDegree() == graph.getMaxDegree());
+            for (int v = 0; v < graph.size(); v++) {
+                auto neighbours = graph.getNeighbours(v);
+                CHECK(replica.getNeighbours(v) == std::vector<int>(neighbours.begin(), neighbours.end()));
+                CHECK(replica.getNeighbours(v).begin() != mapped.getNeighbours(v).begin());
+                CHECK(replica.toOriginal(v) == graph.toOriginal(v));
+            }
+        }
+
+        std::filesystem::remove(path);
+    }
+
+    SECTION("sampling with out-of-core state") {
+        auto params = Parameters{8, 7, 0.95};
+        auto graph = Graph(params.numNodes, Graph::Type::CYCLE);
+
+        SamplingOptions options;
+        options.storageDirectory = directory;
+        auto samples = sample(params, graph, 2, options);
+
+        REQUIRE(samples);
+        REQUIRE(samples->colourings.size() == 2);
+        CHECK(samples->colourings[0].size() == params.numNodes);
+    }
+}
@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
 #include <set>
 #include <vector>
 
@@ -59,6 +62,56 @@ TEST_CASE("graph class", "[Graph]") {
             REQUIRE(mCompGraph.getMaxDegree() == 4);
         }
     }
+
+    SECTION("reordering") {
+        // a path 0 - 1 - ... - 9 with shuffled labels
+        std::vector<int> labels{3, 7, 0, 9, 5, 1, 8, 2, 6, 4};
+        std::vector<Graph::edge_t> edges;
+        std::set<Graph::edge_t> expectedEdges;
+        for (int i = 0; i + 1 < labels.size(); i++) {
+            edges.emplace_back(labels[i], labels[i + 1]);
+            expectedEdges.emplace(std::minmax(labels[i], labels[i + 1]));
+        }
+
+        for (auto ordering : {Graph::Ordering::NONE, Graph::Ordering::BFS, Graph::Ordering::REVERSE_CUTHILL_MCKEE,
+                              Graph::Ordering::DEGREE}) {
+            Graph graph(labels.size(), edges, ordering);
+
+            std::set<int> originals;
+            std::set<Graph::edge_t> actualEdges;
+            for (int v = 0; v < graph.size(); v++) {
+                originals.insert(graph.toOriginal(v));
+                for (int w : graph.getNeighbours(v)) {
+                    actualEdges.emplace(std::minmax(graph.toOriginal(v), graph.toOriginal(w)));
+                }
+            }
+
+            CHECK(originals.size() == labels.size());
+            CHECK(actualEdges == expectedEdges);
+        }
+
+        SECTION("reverse Cuthill-McKee recovers the path") {
+            Graph graph(labels.size(), edges, Graph::Ordering::REVERSE_CUTHILL_MCKEE);
+            for (int v = 0; v < graph.size(); v++) {
+                for (int w : graph.getNeighbours(v)) {
+                    CHECK(std::abs(v - w) == 1);
+                }
+            }
+        }
+
+        SECTION("colourings are returned in the original labels") {
+            Graph graph(labels.size(), edges, Graph::Ordering::REVERSE_CUTHILL_MCKEE);
+            colouring_t internal(labels.size());
+            for (int v = 0; v < graph.size(); v++) {
+                internal[v] = v;
+            }
+
+            colouring_t original = graph.toOriginal(internal);
+            for (int v = 0; v < graph.size(); v++) {
+                CHECK(original[graph.toOriginal(v)] == v);
+            }
+        }
+    }
 }
 
 
@@ -70,6 +123,144 @@ TEST_CASE("sampler class", "[Sampler]") {
         SECTION("generate a sample") {
             REQUIRE_NOTHROW(sample(params, graph));
         }
+
+        SECTION("generate a sample on a reordered graph") {
+            auto reordered = Graph(params.numNodes, Graph::Type::CYCLE, Graph::Ordering::REVERSE_CUTHILL_MCKEE);
+            auto colouring = sample(params, reordered);
+            REQUIRE(colouring);
+            CHECK(colouring->size() == params.numNodes);
+        }
+
+        SECTION("generate samples with narrow colours") {
+            auto colouring = sample<std::uint8_t>(params, graph);
+            REQUIRE(colouring);
+            REQUIRE(colouring->size() == params.numNodes);
+            for (std::uint8_t colour : *colouring) {
+                CHECK(colour < params.maxColours);
+            }
+
+            SamplingOptions options{.engine = SamplingOptions::Engine::GLAUBER, .sweeps = 5, .chains = 2};
+            auto samples = sample<std::uint16_t>(params, graph, 4, options);
+            REQUIRE(samples);
+            CHECK(samples->colourings.size() == 4);
+        }
+
+        SECTION("reject a colour type too narrow for q") {
+            CHECK_THROWS_AS(sample<std::uint8_t>(Parameters{5, 300, 0.95}, graph), std::invalid_argument);
+        }
+    }
+
+    SECTION("regenerated history draws the same samples as the full history") {
+        // on K4 most samples run for several epochs, so the replay regenerates some of them
+        auto k4Params = Parameters{4, 7, 0.7};
+        auto k4       = Graph(k4Params.numNodes, Graph::Type::COMPLETE);
+
+        SamplingOptions options;
+        seed(5, 0);
+        auto full = sample(k4Params, k4, 20, options);
+
+        options.history = SamplingOptions::History::REGENERATED;
+        seed(5, 0);
+        auto regenerated = sample(k4Params, k4, 20, options);
+
+        REQUIRE(full);
+        REQUIRE(regenerated);
+        CHECK(regenerated->colourings == full->colourings);
+        CHECK(regenerated->epochs == full->epochs);
+        CHECK(std::any_of(full->epochs.begin(), full->epochs.end(), [](int epochs) { return epochs > 2; }));
+    }
+
+    SECTION("conditional sampling") {
+        // a path whose labels are shuffled by the reordering
+        std::vector<Graph::edge_t> edges{{3, 7}, {7, 0}, {0, 9}, {9, 5}, {5, 1}, {1, 8}, {8, 2}, {2, 6}, {6, 4}};
+        auto path = Graph(10, edges, Graph::Ordering::REVERSE_CUTHILL_MCKEE);
+        auto pathParams = Parameters{10, 7, 0.95};
+
+        SamplingOptions options;
+        options.pinned = {-1, 2, -1, 5, -1, -1, 0, -1, 6, -1};
+
+        SECTION("pinned vertices keep their colours") {
+            auto samples = sample(pathParams, path, 5, options);
+            REQUIRE(samples);
+            for (const colouring_t &colouring : samples->colourings) {
+                for (int v = 0; v < path.size(); v++) {
+                    if (options.pinned[v] >= 0) {
+                        CHECK(colouring[v] == options.pinned[v]);
+                    } else {
+                        CHECK(colouring[v] < pathParams.maxColours);
+                    }
+                }
+            }
+        }
+
+        SECTION("the schedule covers only the free vertices") {
+            const std::vector<int> free{0, 2, 7};
+            CHECK(getPhaseTwoIters(path, pathParams, free) < getPhaseTwoIters(path, pathParams));
+            CHECK(getPhaseTwoIters(path, pathParams, {}) == 0);
+
+            std::vector<int> all(path.size());
+            for (int v = 0; v < path.size(); v++) {
+                all[v] = v;
+            }
+            CHECK(getPhaseTwoIters(path, pathParams, all) == getPhaseTwoIters(path, pathParams));
+        }
+
+        SECTION("the schedule of a large graph does not overflow") {
+            // n^2 q alone exceeds the range of an int
+            const Graph cycle(20000, Graph::Type::CYCLE);
+            const Parameters cycleParams{cycle.size(), 7, 0.95};
+            CHECK(getPhaseTwoIters(cycle, cycleParams) > std::numeric_limits<int>::max());
+        }
+
+        SECTION("every vertex pinned") {
+            options.pinned = {0, 1, 2, 3, 4, 5, 6, 0, 1, 2};
+            auto samples = sample(pathParams, path, 1, options);
+            REQUIRE(samples);
+            CHECK(samples->colourings[0] == options.pinned);
+            CHECK(samples->epochs[0] == 0);
+        }
+
+        SECTION("reject invalid pins") {
+            options.pinned.pop_back();
+            CHECK_THROWS_AS(sample(pathParams, path, 1, options), std::invalid_argument);
+
+            options.pinned = std::vector<int>(path.size(), 7);
+            CHECK_THROWS_AS(sample(pathParams, path, 1, options), std::invalid_argument);
+
+            options.pinned = std::vector<int>(path.size(), -1);
+            options.engine = SamplingOptions::Engine::GLAUBER;
+            CHECK_THROWS_AS(sample(pathParams, path, 1, options), std::invalid_argument);
+        }
     }
 }
 
+
+TEST_CASE("parameter sweep", "[Sampler]") {
+    auto graph = Graph(5, Graph::Type::CYCLE);
+
+    // T = 1.5 and q = 4 fail verification and are skipped
+    std::vector<SweepPoint> points;
+    std::vector<Parameters> skipped;
+    sweep(
+        graph, {0.9, 0.95, 1.5}, {7, 4}, 3, 3, [&points](const SweepPoint &point) { points.push_back(point); },
+        [&](const Parameters &parameters, const std::vector<std::string> &violations) {
+            CHECK(violations == parameters.violations(graph));
+            CHECK_FALSE(violations.empty());
+            skipped.push_back(parameters);
+        });
+
+    CHECK(skipped.size() == 4);
+    for (const Parameters &parameters : skipped) {
+        CHECK((parameters.maxColours == 4 || parameters.temperature > 1));
+    }
+
+    REQUIRE(points.size() == 2);
+    for (const SweepPoint &point : points) {
+        CHECK(point.parameters.maxColours == 7);
+        CHECK(point.parameters.temperature < 1);
+        REQUIRE(point.colourings.size() == 3);
+        for (const colouring_t &colouring : point.colourings) {
+            CHECK(colouring.size() == graph.size());
+        }
+    }
+}
@@ -0,0 +1,44 @@
+#include <filesystem>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "shard.hpp"
+
+
+TEST_CASE("seeded samples do not depend on the shards", "[Shard]") {
+    const Parameters params{5, 9, 0.9};
+    const Graph graph(params.numNodes, Graph::Type::COMPLETE);
+
+    // more samples than a block, and not a multiple of it
+    const int numSamples = 20;
+
+    for (SamplingOptions::Engine engine : {SamplingOptions::Engine::PERFECT, SamplingOptions::Engine::LOCKSTEP}) {
+        SamplingOptions sampling;
+        sampling.engine = engine;
+
+        std::vector<colouring_t> seeded;
+        REQUIRE(sampleSeeded(params, graph, numSamples, sampling, 5,
+                             [&seeded](const colouring_t &colouring) { seeded.push_back(colouring); }));
+        REQUIRE(seeded.size() == numSamples);
+
+        for (int shards : {1, 3}) {
+            const ShardOptions options{.shards         = shards,
+                                       .threads        = 2,
+                                       .seed           = 5,
+                                       .replicateGraph = false,
+                                       .directory      = std::filesystem::temp_directory_path()};
+            std::vector<colouring_t> sharded;
+            REQUIRE(sampleSharded(params, graph, numSamples, sampling, options,
+                                  [&sharded](const colouring_t &colouring) { sharded.push_back(colouring); }));
+            CHECK(sharded == seeded);
+        }
+    }
+
+    SECTION("the Glauber chains are not seeded") {
+        SamplingOptions sampling;
+        sampling.engine = SamplingOptions::Engine::GLAUBER;
+        CHECK_THROWS_AS(sampleSeeded(params, graph, 1, sampling, 5, [](const colouring_t &) {}),
+                        std::invalid_argument);
+    }
+}
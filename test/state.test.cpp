@@ -1,3 +1,5 @@
+#include <random>
+
 #include <catch2/catch_test_macros.hpp>
 #include "state.hpp"
 
@@ -108,3 +110,36 @@ TEST_CASE("queries", "[Queries]") {
         CHECK(queries::m_Q(state.graph, state.parameters, state.boundingChain, 3, 1) == 1);
     }
 }
+
+
+TEST_CASE("neighbour counts", "[Queries]") {
+    auto params = Parameters{40, 9, 0.9};
+    auto graph  = Graph::random(params.numNodes, 4, 3);
+    BoundingList defaultBL(params.maxColours);
+    defaultBL.set();
+
+    State state{.parameters    = params,
+                .graph         = graph,
+                .colouring     = colouring_t(params.numNodes),
+                .boundingChain = boundingchain_t(params.numNodes, defaultBL)};
+    state.neighbourCounts = NeighbourCounts(graph, params.maxColours, state.boundingChain);
+
+    // bounding lists of every size, including singletons and the empty list
+    std::mt19937 gen{5};
+    std::uniform_int_distribution<int> vertex(0, params.numNodes - 1), size(0, 3), colour(0, params.maxColours - 1);
+    for (int i = 0; i < 500; i++) {
+        std::vector<int> colours(size(gen));
+        for (int &c : colours) {
+            c = colour(gen);
+        }
+        state.setBoundingList(vertex(gen), BoundingList(params.maxColours, colours));
+
+        for (int v = 0; v < params.numNodes; v++) {
+            REQUIRE(state.neighbourCounts.unfixedColours(v) ==
+                    queries::getUnfixedColours(graph, params, state.boundingChain, v));
+            for (int c = 0; c < params.maxColours; c++) {
+                REQUIRE(state.neighbourCounts.m_Q(v, c) == queries::m_Q(graph, params, state.boundingChain, v, c));
+            }
+        }
+    }
+}
@@ -0,0 +1,52 @@
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "sampler.hpp"
+
+
+TEST_CASE("sample stream", "[Stream]") {
+    auto params = Parameters{6, 7, 0.95};
+    auto graph  = Graph(params.numNodes, Graph::Type::CYCLE);
+
+    SECTION("next returns complete samples") {
+        SampleStream stream(params, graph, 2, 2);
+        for (int i = 0; i < 5; i++) {
+            colouring_t colouring = stream.next();
+            REQUIRE(colouring.size() == params.numNodes);
+            for (int colour : colouring) {
+                CHECK(colour < params.maxColours);
+            }
+            stream.recycle(std::move(colouring));
+        }
+    }
+
+    SECTION("the stream can be iterated over") {
+        BasicSampleStream<std::uint8_t> stream(params, graph, 3);
+
+        int count = 0;
+        for (const auto &colouring : stream) {
+            CHECK(colouring.size() == params.numNodes);
+            if (++count == 10) {
+                break;
+            }
+        }
+        CHECK(count == 10);
+    }
+
+    SECTION("the stream requires verified parameters") {
+        CHECK_THROWS_AS(SampleStream(Parameters{6, 4, 0.95}, graph), std::invalid_argument);
+        CHECK_THROWS_AS(BasicSampleStream<std::uint8_t>(Parameters{6, 300, 0.95}, graph), std::invalid_argument);
+    }
+
+    SECTION("the error names the violations") {
+        const Parameters unsupported{6, 4, 0.95};
+        std::string message = "The parameters of a sample stream are not supported:";
+        for (const std::string &violation : unsupported.violations(graph)) {
+            message += "\n" + violation;
+        }
+        CHECK_THROWS_WITH(SampleStream(unsupported, graph), message);
+    }
+}
@@ -0,0 +1,38 @@
+#include <sstream>
+#include <string>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "sampler.hpp"
+
+
+TEST_CASE("timeline trace", "[Trace]") {
+    auto params = Parameters{5, 7, 0.95};
+    auto graph  = Graph(params.numNodes, Graph::Type::CYCLE);
+
+    SECTION("spans are recorded for every worker") {
+        startTrace();
+        sweep(graph, {0.9, 0.95}, {7}, 2, 2, [](const SweepPoint &) {});
+        std::ostringstream out;
+        stopTrace(out);
+
+        const std::string json = out.str();
+        CHECK(json.find("\"traceEvents\"") != std::string::npos);
+        for (const char *name : {"\"sample\"", "\"epoch\"", "\"phase one\"", "\"phase two\"", "\"replay\""}) {
+            CHECK(json.find(name) != std::string::npos);
+        }
+        CHECK(json.find("\"nonSingleton\": ") != std::string::npos);
+        CHECK(json.find("\"thread_name\"") != std::string::npos);
+    }
+
+    SECTION("nothing is recorded once stopped") {
+        startTrace();
+        std::ostringstream out;
+        stopTrace(out);
+
+        REQUIRE(sample(params, graph));
+        std::ostringstream after;
+        stopTrace(after);
+        CHECK(after.str().find("\"ph\": \"X\"") == std::string::npos);
+    }
+}
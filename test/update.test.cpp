@@ -5,14 +5,6 @@
 #include "update.hpp"
 
 
-TEST_CASE("helpers", "[Update]") {
-    SECTION("compute power") {
-        std::vector<int> counts{0, 1, 2, 3};
-        std::vector<long double> result{1, 0.5, 0.25, 0.125};
-        CHECK(pow(0.5, counts) == result);
-    }
-}
-
 TEST_CASE("compress class", "[Compress]") {
     auto params = Parameters{5, 7, 0.99};
     auto graph = Graph(params.numNodes, Graph::Type::CYCLE);
@@ -23,13 +15,16 @@ TEST_CASE("compress class", "[Compress]") {
                 .graph         = graph,
                 .colouring     = colouring_t(params.numNodes),
                 .boundingChain = boundingchain_t(params.numNodes, defaultBL)};
+    state.neighbourCounts = NeighbourCounts(graph, params.maxColours, state.boundingChain);
 
     SECTION("public methods")
     {
         BoundingList boundingList(params.maxColours);
         boundingList.set(0), boundingList.set(1), boundingList.set(2);
 
-        CompressUpdate compressUpdate(state, 3, boundingList);
+        ColourSets sets;
+        sets.reserve(params.maxColours, 1);
+        CompressUpdate compressUpdate(state, 3, sets.add(boundingList));
 
         SECTION("colour1 (c1) is added to bounding list") {
             boundingList.set(compressUpdate.c1);
@@ -45,6 +40,25 @@ TEST_CASE("compress class", "[Compress]") {
     }
 }
 
+TEST_CASE("colour sets", "[Compress]") {
+    BoundingList first(70), second(70);
+    first.set(0).set(64).set(69);
+    second.set(3);
+
+    ColourSets sets;
+    sets.reserve(70, 2);
+    const ColourSet A = sets.add(first);
+    const ColourSet B = sets.add(second);
+
+    BoundingList copy(1);
+    A.copyTo(copy);
+    CHECK(copy == first);
+    B.copyTo(copy);
+    CHECK(copy == second);
+    CHECK(A.size() == 70);
+    CHECK((A[64] && !A[63] && B[3] && !B[0]));
+}
+
 TEST_CASE("contract class", "[Contract]") {
     auto params = Parameters{5, 7, 0.99};
     auto graph = Graph(params.numNodes, Graph::Type::CYCLE);
@@ -55,13 +69,17 @@ TEST_CASE("contract class", "[Contract]") {
                 .graph         = graph,
                 .colouring     = colouring_t(params.numNodes),
                 .boundingChain = boundingchain_t(params.numNodes, defaultBL)};
+    state.neighbourCounts = NeighbourCounts(graph, params.maxColours, state.boundingChain);
 
     SECTION("public methods") {
         BoundingList boundingList(params.maxColours);
         boundingList.set(0), boundingList.set(1), boundingList.set(2);
 
-        CompressUpdate compressUpdateNode1(state, 1, boundingList);
-        CompressUpdate compressUpdateNode4(state, 4, boundingList);
+        ColourSets sets;
+        sets.reserve(params.maxColours, 1);
+        const ColourSet A = sets.add(boundingList);
+        CompressUpdate compressUpdateNode1(state, 1, A);
+        CompressUpdate compressUpdateNode4(state, 4, A);
         ContractUpdate contractUpdate(state, 0);
 
         SECTION("bounding list is either {c2} or {c1, c2}") {
@@ -1,31 +1,134 @@
 #include <boost/program_options.hpp>
+#include <fstream>
 #include <iostream>
+#include <filesystem>
 #include <memory>
+#include <random>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "sampler.hpp"
+#include "shard.hpp"
 
-static std::optional<std::pair<Graph::Type, Parameters>> parse_params(int argc, char **argv) {
+/// an inclusive range start:stop[:step]
+struct Range {
+    long double start, stop, step = 1;
+
+    template<typename T>
+    std::vector<T> values() const {
+        std::vector<T> result;
+        for (int i = 0; step > 0 && start + i * step <= stop + step * 1e-9L; i++) {
+            result.push_back(static_cast<T>(start + i * step));
+        }
+        return result;
+    }
+};
+
+static std::istream &operator>>(std::istream &is, Range &range) {
+    char separator;
+    if (!(is >> range.start >> separator >> range.stop) || separator != ':') {
+        is.setstate(std::ios_base::failbit);
+        return is;
+    }
+
+    range.step = 1;
+    if (is >> separator && separator == ':') {
+        is >> range.step;
+    }
+    is.clear(is.rdstate() & ~std::ios_base::failbit);
+    return is;
+}
+
+struct CliOptions {
+    Graph::Type type;
+    Graph::Ordering ordering;
+    Parameters params;
+    SamplingOptions sampling;
+    int samples;
+
+    // binary graph files, see Graph::save
+    std::string graphFile;
+    std::string saveGraphFile;
+
+    // parameter sweep
+    bool sweep;
+    std::optional<Range> temperatures;
+    std::optional<Range> colours;
+    int threads;
+
+    // forked, NUMA-pinned workers
+    std::optional<ShardOptions> shards;
+
+    // seed of the samples drawn without shards, see sampleSeeded
+    std::optional<std::uint64_t> seed;
+
+    // Chrome trace-event JSON timeline of the perfect sampler
+    std::string traceFile;
+};
+
+static std::optional<CliOptions> parse_params(int argc, char **argv) {
     namespace po = boost::program_options;
 
     po::variables_map vm;
     po::options_description description("Program Options");
 
-    Graph::Type type;
-    Parameters params;
+    CliOptions options;
 
     // Declare arguments
     // clang-format off
     description.add_options()
         ("help,h", "Display this help message")
         (
-            "temperature,T", po::value<long double>(&params.temperature)->default_value(0.95L),
+            "temperature,T", po::value<long double>(&options.params.temperature)->default_value(0.95L),
             "The strength of interactions; must be in the interval (0, 1)"
         )
-        ("colours,q", po::value<int>(&params.maxColours)->default_value(7),             "Number of colours")
-        ("vertices,v",  po::value<int>(&params.numNodes)->default_value(10),            "Number of vertices")
-        ("type,t",    po::value<Graph::Type>(&type)->default_value(Graph::Type::CYCLE), "Type of graph");
+        ("colours,q",  po::value<int>(&options.params.maxColours)->default_value(7),            "Number of colours")
+        ("vertices,v", po::value<int>(&options.params.numNodes)->default_value(10),             "Number of vertices")
+        ("type,t",     po::value<Graph::Type>(&options.type)->default_value(Graph::Type::CYCLE), "Type of graph")
+        (
+            "ordering", po::value<Graph::Ordering>(&options.ordering)->default_value(Graph::Ordering::NONE, "none"),
+            "Internal vertex ordering; one of none, bfs, rcm, degree"
+        )
+        ("graph,g",    po::value<std::string>(&options.graphFile),    "Memory-map the graph from a binary graph file")
+        ("save-graph", po::value<std::string>(&options.saveGraphFile), "Write the graph to a binary graph file")
+        (
+            "storage-dir", po::value<std::string>(&options.sampling.storageDirectory),
+            "Keep the sampler state in memory-mapped files in this directory"
+        )
+        ("samples,n",  po::value<int>(&options.samples)->default_value(1),                       "Number of samples")
+        (
+            "history", po::value<SamplingOptions::History>(&options.sampling.history)
+                           ->default_value(SamplingOptions::History::FULL, "full"),
+            "Perfect sampler history; full, or regenerated to rerun each epoch during the replay in less memory"
+        )
+        (
+            "engine,e",
+            po::value<SamplingOptions::Engine>(&options.sampling.engine)
+                ->default_value(SamplingOptions::Engine::PERFECT, "perfect"),
+            "Sampling engine; perfect, lockstep for batches of perfect samples, or glauber for approximate sampling"
+        )
+        ("sweeps",     po::value<int>(&options.sampling.sweeps)->default_value(100),   "Glauber burn-in sweeps per chain")
+        ("thinning",   po::value<int>(&options.sampling.thinning)->default_value(10),  "Glauber sweeps between samples")
+        ("chains",     po::value<int>(&options.sampling.chains)->default_value(4),     "Glauber chains run in parallel")
+        ("sweep",      po::bool_switch(&options.sweep),                                "Sample over a grid of T and q")
+        ("temperature-range", po::value<Range>(),  "Sweep temperatures start:stop:step (defaults to --temperature)")
+        ("colour-range",      po::value<Range>(),  "Sweep colour counts start:stop[:step] (defaults to --colours)")
+        (
+            "threads", po::value<int>(&options.threads)->default_value(std::thread::hardware_concurrency()),
+            "Threads used by the sweep, or by each shard (defaults to the CPUs of its NUMA node)"
+        )
+        (
+            "shards", po::value<int>(),
+            "Fork this many worker processes, pinned to NUMA nodes in turn, and merge their samples; 0 for one per node"
+        )
+        ("seed",       po::value<std::uint64_t>(), "Seed for the perfect and lockstep engines; the samples depend only on the seed")
+        ("replicate-graph", po::bool_switch(),     "Give each shard a copy of the graph on its own NUMA node")
+        (
+            "shard-dir", po::value<std::string>()->default_value(std::filesystem::temp_directory_path()),
+            "Directory for the samples of each shard before they are merged"
+        )
+        ("trace",      po::value<std::string>(&options.traceFile), "Write a timeline of the perfect sampler (Chrome trace JSON)");
 
     // parse arguments and save them in the variable map (vm)
     po::store(
@@ -41,33 +144,129 @@ static std::optional<std::pair<Graph::Type, Parameters>> parse_params(int argc,
     po::notify(vm);
     // clang-format on
 
-    return {
-        {type, params}
-    };
+    if (vm.count("temperature-range")) {
+        options.temperatures = vm["temperature-range"].as<Range>();
+    }
+    if (vm.count("colour-range")) {
+        options.colours = vm["colour-range"].as<Range>();
+    }
+    if (options.sampling.engine == SamplingOptions::Engine::LOCKSTEP &&
+        (options.sampling.history != SamplingOptions::History::FULL || !options.sampling.storageDirectory.empty())) {
+        std::cout << "--history and --storage-dir are only supported by the perfect engine." << std::endl;
+        return std::nullopt;
+    }
+    // the sweep draws its samples with the perfect engine, in memory, on threads of its own
+    if (options.sweep && (options.sampling.engine != SamplingOptions::Engine::PERFECT ||
+                          options.sampling.history != SamplingOptions::History::FULL ||
+                          !options.sampling.storageDirectory.empty() || vm.count("shards"))) {
+        std::cout << "--sweep samples with the perfect engine and a full history, in memory and without --shards."
+                  << std::endl;
+        return std::nullopt;
+    }
+    if (vm.count("shards")) {
+        options.shards = ShardOptions{
+            .shards         = vm["shards"].as<int>(),
+            .threads        = vm["threads"].defaulted() ? 0 : options.threads,
+            .seed           = vm.count("seed") ? vm["seed"].as<std::uint64_t>() : std::random_device{}(),
+            .replicateGraph = vm["replicate-graph"].as<bool>(),
+            .directory      = vm["shard-dir"].as<std::string>()};
+        if (options.shards->shards == 0) {
+            options.shards->shards = numaNodes().size();
+        }
+        if (options.sampling.engine == SamplingOptions::Engine::GLAUBER) {
+            std::cout << "--shards supports the perfect and lockstep engines." << std::endl;
+            return std::nullopt;
+        }
+    } else if (vm.count("seed")) {
+        // the sweep and the Glauber chains sample on threads of their own
+        if (options.sweep || options.sampling.engine == SamplingOptions::Engine::GLAUBER) {
+            std::cout << "--seed supports the perfect and lockstep engines, without --sweep." << std::endl;
+            return std::nullopt;
+        }
+        options.seed = vm["seed"].as<std::uint64_t>();
+    }
+
+    return options;
+}
+
+/// records a timeline from construction and writes it to a file on destruction
+struct ScopedTrace {
+    explicit ScopedTrace(const std::string &path) : out(path) { startTrace(); }
+
+    ~ScopedTrace() { stopTrace(out); }
+
+    std::ofstream out;
+};
+
+static void print(const colouring_t &colouring) {
+    std::cout << "| ";
+    for (int i{}; i < colouring.size(); ++i) {
+        std::cout << i << ": " << colouring[i] << " | ";
+    }
+    std::cout << std::endl;
 }
 
 int main(int argc, char **argv) {
-    auto paramsMb = parse_params(argc, argv);
-    if (!paramsMb) {
+    auto optionsMb = parse_params(argc, argv);
+    if (!optionsMb) {
         return 1;
     }
 
     //  check if parameters match conditions for theorem
     //  note that the algorithm still works if B is not in the correct interval,
     //  but there is no guarantee
-    auto [type, params] = std::move(paramsMb.value());
-    auto graph                 = Graph(params.numNodes, type);
-    std::optional<colouring_t> colouringMb = sample(params, graph);
-    if (!colouringMb) {
+    CliOptions &options = *optionsMb;
+    auto graph          = options.graphFile.empty() ? Graph(options.params.numNodes, options.type, options.ordering)
+                                                    : Graph::map(options.graphFile);
+    options.params.numNodes = graph.size();
+
+    if (!options.saveGraphFile.empty()) {
+        graph.save(options.saveGraphFile);
+    }
+
+    std::optional<ScopedTrace> trace;
+    if (!options.traceFile.empty()) {
+        trace.emplace(options.traceFile);
+    }
+
+    if (options.sweep) {
+        Range temperatures = options.temperatures.value_or(
+            Range{options.params.temperature, options.params.temperature});
+        Range colours = options.colours.value_or(
+            Range{static_cast<long double>(options.params.maxColours), static_cast<long double>(options.params.maxColours)});
+
+        sweep(graph, temperatures.values<long double>(), colours.values<int>(), options.samples, options.threads,
+              [](const SweepPoint &point) {
+                  std::cout << "T: " << point.parameters.temperature << ", q: " << point.parameters.maxColours
+                            << std::endl;
+                  for (const colouring_t &colouring : point.colourings) {
+                      print(colouring);
+                  }
+              });
+        return 0;
+    }
+
+    if (options.shards) {
+        return sampleSharded(options.params, graph, options.samples, options.sampling, *options.shards, print) ? 0 : 1;
+    }
+
+    if (options.seed) {
+        return sampleSeeded(options.params, graph, options.samples, options.sampling, *options.seed, print) ? 0 : 1;
+    }
+
+    std::optional<Samples> samplesMb = sample(options.params, graph, options.samples, options.sampling);
+    if (!samplesMb) {
         return 1;
     }
-    colouring_t colouring = *colouringMb;
 
-    std::cout << "| ";
-    for (int i{}; i < colouring.size(); ++i) {
-        std::cout << i << ": " << colouring[i] << " | ";
+    for (const colouring_t &colouring : samplesMb->colourings) {
+        print(colouring);
+    }
+
+    if (samplesMb->diagnostics) {
+        std::cout << "autocorrelation time: " << samplesMb->diagnostics->autocorrelationTime
+                  << ", R-hat: " << samplesMb->diagnostics->rHat << std::endl;
     }
-    std::cout << std::endl;
 
     return 0;
 }
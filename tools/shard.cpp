@@ -0,0 +1,268 @@
+#include "shard.hpp"
+
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+// the samples drawn from one seeded stream; a multiple of the lanes of the lockstep engine
+constexpr int blockSize = 8;
+
+/// parse a list of CPUs such as "0-3,8-11"
+std::vector<int> parseCpuList(const std::string &list) {
+    std::vector<int> cpus;
+    std::istringstream in(list);
+    std::string range;
+    while (std::getline(in, range, ',')) {
+        std::istringstream parts(range);
+        int first;
+        if (!(parts >> first)) {
+            continue;
+        }
+
+        int last = first;
+        if (char dash; parts >> dash) {
+            parts >> last;
+        }
+        for (int cpu = first; cpu <= last; cpu++) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+/// restrict the calling process, and the threads it starts from now on, to cpus; best effort, since an
+/// unpinned worker still produces the same samples
+void pin(const std::vector<int> &cpus) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    sched_setaffinity(0, sizeof(set), &set);
+#endif
+}
+
+/// \return the samples of block, the randomness of which comes from seed(seedValue, block) alone
+Samples sampleBlock(const Parameters &parameters, const Graph &graph, int numSamples, const SamplingOptions &sampling,
+                    std::uint64_t seedValue, int block) {
+    seed(seedValue, block);
+    const int count = std::min(blockSize, numSamples - block * blockSize);
+
+    // parameters were verified by the caller, so samples are always produced
+    return *sample(parameters, graph, count, sampling);
+}
+
+/// draw the samples of the blocks [first, last) on numThreads threads and write them, in order, to path
+void runShard(const Parameters &parameters, const Graph &graph, int numSamples, const SamplingOptions &sampling,
+              std::uint64_t seedValue, int first, int last, int numThreads, const std::string &path) {
+    const int begin = first * blockSize;
+    std::vector<colouring_t> colourings(std::min(numSamples, last * blockSize) - begin);
+
+    std::atomic<int> next{first};
+    std::mutex mutex;
+    std::exception_ptr error;
+    auto worker = [&]() {
+        try {
+            for (int block = next++; block < last; block = next++) {
+                Samples samples = sampleBlock(parameters, graph, numSamples, sampling, seedValue, block);
+                std::move(samples.colourings.begin(), samples.colourings.end(),
+                          colourings.begin() + (block * blockSize - begin));
+            }
+        } catch (...) {
+            next = last;
+            std::lock_guard<std::mutex> lock(mutex);
+            error = error ? error : std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < std::max(numThreads, 1); i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    for (const colouring_t &colouring : colourings) {
+        out.write(reinterpret_cast<const char *>(colouring.data()), colouring.size() * sizeof(int));
+    }
+    if (!out.flush()) {
+        throw std::runtime_error("Could not write the samples to " + path);
+    }
+}
+}  // namespace
+
+std::vector<std::vector<int>> numaNodes() {
+    std::map<int, std::vector<int>> nodes;
+
+    std::error_code ec;
+    for (const auto &entry : std::filesystem::directory_iterator("/sys/devices/system/node", ec)) {
+        const std::string name = entry.path().filename();
+        if (name.rfind("node", 0) != 0 || name.size() == 4 ||
+            !std::all_of(name.begin() + 4, name.end(), [](char c) { return std::isdigit(c); })) {
+            continue;
+        }
+
+        std::ifstream in(entry.path() / "cpulist");
+        std::string list;
+        std::getline(in, list);
+
+        // nodes with memory but no CPUs have nothing to pin to
+        if (std::vector<int> cpus = parseCpuList(list); !cpus.empty()) {
+            nodes[std::stoi(name.substr(4))] = std::move(cpus);
+        }
+    }
+
+    std::vector<std::vector<int>> result;
+    for (auto &[node, cpus] : nodes) {
+        result.emplace_back(std::move(cpus));
+    }
+    if (result.empty()) {
+        std::vector<int> &cpus = result.emplace_back(std::max(1u, std::thread::hardware_concurrency()));
+        for (int cpu = 0; cpu < cpus.size(); cpu++) {
+            cpus[cpu] = cpu;
+        }
+    }
+    return result;
+}
+
+bool sampleSeeded(const Parameters &parameters, const Graph &graph, int numSamples, const SamplingOptions &sampling,
+                  std::uint64_t seedValue, const std::function<void(const colouring_t &)> &onSample) {
+    // the Glauber chains run on threads of their own, whose randomness is not seeded
+    if (sampling.engine == SamplingOptions::Engine::GLAUBER) {
+        throw std::invalid_argument("Seeded sampling supports the perfect and lockstep engines.");
+    }
+    if (!parameters.verify(graph)) {
+        return false;
+    }
+
+    for (int block = 0; block * blockSize < numSamples; block++) {
+        const Samples samples = sampleBlock(parameters, graph, numSamples, sampling, seedValue, block);
+        for (const colouring_t &colouring : samples.colourings) {
+            onSample(colouring);
+        }
+    }
+    return true;
+}
+
+bool sampleSharded(const Parameters &parameters, const Graph &graph, int numSamples,
+                   const SamplingOptions &sampling, const ShardOptions &options,
+                   const std::function<void(const colouring_t &)> &onSample) {
+    // the Glauber chains run on threads of their own, whose randomness is not seeded
+    if (sampling.engine == SamplingOptions::Engine::GLAUBER) {
+        throw std::invalid_argument("The sharded driver supports the perfect and lockstep engines.");
+    }
+    if (!parameters.verify(graph)) {
+        return false;
+    }
+
+    const std::vector<std::vector<int>> nodes = numaNodes();
+    const int numShards = std::max(options.shards, 1);
+    const int numBlocks = (numSamples + blockSize - 1) / blockSize;
+
+    // shard s draws the blocks [firstBlock(s), firstBlock(s + 1))
+    auto firstBlock = [&](int shard) { return static_cast<long long>(shard) * numBlocks / numShards; };
+
+    // output buffered by the parent would otherwise be written again by each worker
+    std::cout.flush();
+    std::cerr.flush();
+
+    std::vector<std::string> paths;
+    std::vector<pid_t> workers;
+    std::string forkError;
+    for (int shard = 0; shard < numShards; shard++) {
+        paths.push_back(options.directory + "/potts-shard-" + std::to_string(getpid()) + '-' +
+                        std::to_string(shard) + ".bin");
+
+        const pid_t pid = fork();
+        if (pid < 0) {
+            // wait for the workers already started before reporting the failure
+            forkError = std::string("Could not fork a worker: ") + std::strerror(errno);
+            break;
+        }
+
+        if (pid == 0) {
+            // pin before touching memory, so that the replica and the sampler state are node-local
+            try {
+                const std::vector<int> &cpus = nodes[shard % nodes.size()];
+                pin(cpus);
+
+                const Graph local = options.replicateGraph ? graph.replicate() : graph;
+                runShard(parameters, local, numSamples, sampling, options.seed, firstBlock(shard),
+                         firstBlock(shard + 1), options.threads ? options.threads : static_cast<int>(cpus.size()),
+                         paths.back());
+            } catch (const std::exception &err) {
+                std::cerr << "Shard " << shard << " failed: " << err.what() << std::endl;
+                _exit(1);
+            }
+            _exit(0);
+        }
+        workers.push_back(pid);
+    }
+
+    bool failed = !forkError.empty();
+    for (pid_t pid : workers) {
+        int status;
+        failed |= waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+    }
+
+    // merge the shards in order, so that the samples are those of a single process drawing every block
+    std::exception_ptr error;
+    colouring_t colouring(graph.size());
+    const std::streamsize bytes = colouring.size() * sizeof(int);
+    for (int shard = 0; shard < paths.size(); shard++) {
+        if (!failed && !error) {
+            try {
+                std::ifstream in(paths[shard], std::ios::binary);
+                const int count = std::min<long long>(numSamples, firstBlock(shard + 1) * blockSize) -
+                                  firstBlock(shard) * blockSize;
+                for (int i = 0; i < count; i++) {
+                    if (!in.read(reinterpret_cast<char *>(colouring.data()), bytes)) {
+                        throw std::runtime_error("The samples of shard " + std::to_string(shard) +
+                                                 " are incomplete.");
+                    }
+                    onSample(colouring);
+                }
+            } catch (...) {
+                error = std::current_exception();
+            }
+        }
+        std::error_code ec;
+        std::filesystem::remove(paths[shard], ec);
+    }
+
+    if (failed) {
+        throw std::runtime_error(forkError.empty() ? "A sampling worker failed." : forkError);
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    return true;
+}
@@ -0,0 +1,49 @@
+#ifndef POTTSSAMPLER_SHARD_H
+#define POTTSSAMPLER_SHARD_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "sampler.hpp"
+
+/// the CPUs of each NUMA node, read from /sys/devices/system/node; a single node
+/// holding every CPU when the topology is not available
+std::vector<std::vector<int>> numaNodes();
+
+struct ShardOptions {
+    // worker processes; shard s runs on NUMA node s modulo the number of nodes
+    int shards;
+
+    // sampling threads in each worker
+    int threads;
+
+    // together with the index of a block of samples, fixes the randomness of that block
+    std::uint64_t seed;
+
+    // give each worker a node-local copy of the graph, rather than sharing its pages with the parent
+    bool replicateGraph;
+
+    // where the workers write their samples before they are merged
+    std::string directory;
+};
+
+/// draw numSamples samples on the calling thread, in the blocks of sampleSharded and with the same randomness,
+/// so that they are the samples sampleSharded draws under the same seed
+/// \throw std::invalid_argument for the Glauber engine, whose chains are not seeded
+/// \return false if the parameters fail Parameters::verify
+bool sampleSeeded(const Parameters &parameters, const Graph &graph, int numSamples, const SamplingOptions &sampling,
+                  std::uint64_t seed, const std::function<void(const colouring_t &)> &onSample);
+
+/// draw numSamples samples across options.shards forked worker processes, each pinned to a NUMA node
+/// samples are drawn in blocks, the randomness of each coming from seed(options.seed, block), so the
+/// merged samples depend only on the seed; onSample is called with the samples in order, once every
+/// worker has finished
+/// \throw std::runtime_error if a worker fails
+/// \return false if the parameters fail Parameters::verify
+bool sampleSharded(const Parameters &parameters, const Graph &graph, int numSamples,
+                   const SamplingOptions &sampling, const ShardOptions &options,
+                   const std::function<void(const colouring_t &)> &onSample);
+
+#endif  // POTTSSAMPLER_SHARD_H